@@ -0,0 +1,281 @@
+#include "batch.h"
+#include "maze.h"
+#include "mpmc_queue.h"
+#include "solvers.h"
+#include "tour.h"
+#include "validate.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// room in each queue between stages
+const size_t BATCH_QUEUE_SIZE = 256;
+
+/**
+ * One maze going through the pipeline.
+ */
+struct Job
+{
+    long id;
+    int rows;
+    int cols;
+    unsigned seed;
+    string alg;
+    bool render;
+
+    unique_ptr<Maze> maze;
+    path solution;
+    bool valid;
+};
+
+using JobQueue = MpmcQueue<Job*>;
+
+bool parse_batch_threads(const string& s, BatchThreads& threads)
+{
+    vector<int> counts;
+    stringstream in(s);
+    string part;
+    while(getline(in, part, ':'))
+    {
+        int n = atoi(part.c_str());
+        if(n <= 0)
+        {
+            return false;
+        }
+        counts.push_back(n);
+    }
+
+    if(counts.size() == 1)
+    {
+        threads.gen = threads.solve = threads.validate = threads.render = counts[0];
+    }
+    else if(counts.size() == 4)
+    {
+        threads.gen = counts[0];
+        threads.solve = counts[1];
+        threads.validate = counts[2];
+        threads.render = counts[3];
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Read one job spec.
+ *
+ * @return false if the line isn't a job (blank, comment, or bad)
+ */
+static bool parse_job(const string& line, long id, Job& job)
+{
+    stringstream in(line);
+    int render = 0;
+    if(!(in >> job.rows >> job.cols >> job.seed >> job.alg))
+    {
+        return false;
+    }
+    in >> render;
+
+    job.id = id;
+    job.render = render != 0;
+    return job.rows >= 1 && job.cols >= 1 &&
+           (job.alg == "dfs" || job.alg == "bfs" || job.alg == "dij" || job.alg == "tour");
+}
+
+/**
+ * Get the next job for a stage, waiting while the stage before is still working.
+ *
+ * @param in the stage's queue
+ * @param upstream number of workers still running in the stage before
+ * @return false once the stage before is done and the queue is empty
+ */
+static bool next_job(JobQueue& in, atomic<int>& upstream, Job*& job)
+{
+    while(!in.try_pop(job))
+    {
+        if(upstream.load(memory_order_acquire) == 0)
+        {
+            // workers push everything before they sign off,
+            // so one last look is enough
+            return in.try_pop(job);
+        }
+        this_thread::yield();
+    }
+    return true;
+}
+
+static void solve_job(Job& job, SolverWorkspace& ws)
+{
+    const Maze& m = *job.maze;
+    int goal = job.rows * job.cols - 1;
+
+    if(job.alg == "dfs")
+    {
+        dfs_search(m, ws, 0, goal);
+        job.solution = ws.to_list();
+    }
+    else if(job.alg == "bfs")
+    {
+        bfs_search(m, ws, 0, goal);
+        job.solution = ws.to_list();
+    }
+    else if(job.alg == "dij")
+    {
+        EdgeCosts costs(m);
+        dijkstra_search(costs, ws, 0, goal);
+        job.solution = ws.to_list();
+    }
+    else
+    {
+        // the solve stage already has its share of the cores,
+        // so the tour runs on this worker's thread alone
+        int cost;
+        job.solution = solve_waypoint_tour(m, corner_waypoints(job.rows, job.cols), cost,
+                                           nullptr, nullptr, 1);
+    }
+}
+
+/**
+ * Run the pipeline.
+ * The main thread reads jobs and feeds the generate stage,
+ * the render stage is the end of the line and prints the results.
+ */
+int run_batch(istream& in, ostream& out, const BatchThreads& threads)
+{
+    JobQueue to_gen(BATCH_QUEUE_SIZE);
+    JobQueue to_solve(BATCH_QUEUE_SIZE);
+    JobQueue to_validate(BATCH_QUEUE_SIZE);
+    JobQueue to_render(BATCH_QUEUE_SIZE);
+
+    // how many workers are still running in each stage
+    atomic<int> reading(1);
+    atomic<int> generating(threads.gen);
+    atomic<int> solving(threads.solve);
+    atomic<int> validating(threads.validate);
+
+    atomic<int> invalid(0);
+    atomic<long> finished(0);
+    mutex out_lock;
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+
+    for(int i = 0; i < threads.gen; i++)
+    {
+        workers.emplace_back([&]()
+        {
+            Job* job;
+            while(next_job(to_gen, reading, job))
+            {
+                job->maze.reset(new Maze(job->rows, job->cols, job->seed));
+                to_solve.push(job);
+            }
+            generating--;
+        });
+    }
+
+    for(int i = 0; i < threads.solve; i++)
+    {
+        workers.emplace_back([&]()
+        {
+            // each solver reuses its own workspace for every job
+            SolverWorkspace ws;
+            Job* job;
+            while(next_job(to_solve, generating, job))
+            {
+                solve_job(*job, ws);
+                to_validate.push(job);
+            }
+            solving--;
+        });
+    }
+
+    for(int i = 0; i < threads.validate; i++)
+    {
+        workers.emplace_back([&]()
+        {
+            Job* job;
+            while(next_job(to_validate, solving, job))
+            {
+                job->valid = job->alg == "tour" ? valid_tour(*job->maze, job->solution)
+                                                : valid_solution(*job->maze, job->solution);
+                to_render.push(job);
+            }
+            validating--;
+        });
+    }
+
+    for(int i = 0; i < threads.render; i++)
+    {
+        workers.emplace_back([&]()
+        {
+            Job* job;
+            while(next_job(to_render, validating, job))
+            {
+                // draw the maze outside the lock, only the write is serialized
+                ostringstream text;
+                text << "job " << job->id << ": " << job->rows << "x" << job->cols
+                     << " seed " << job->seed << " " << job->alg
+                     << ": path " << job->solution.size()
+                     << (job->valid ? " valid" : " invalid") << "\n";
+                if(job->render)
+                {
+                    bool weighted = job->alg == "dij" || job->alg == "tour";
+                    job->maze->print_maze_with_path(text, job->solution, weighted, job->alg == "tour");
+                }
+
+                if(!job->valid)
+                {
+                    invalid++;
+                }
+                finished++;
+                {
+                    lock_guard<mutex> guard(out_lock);
+                    out << text.str();
+                }
+                delete job;
+            }
+        });
+    }
+
+    // feed the pipeline
+    string line;
+    long id = 0;
+    while(getline(in, line))
+    {
+        size_t first = line.find_first_not_of(" \t");
+        if(first == string::npos || line[first] == '#')
+        {
+            continue;
+        }
+
+        Job* job = new Job();
+        if(!parse_job(line, id, *job))
+        {
+            cerr << "bad job: " << line << endl;
+            delete job;
+            continue;
+        }
+        id++;
+        to_gen.push(job);
+    }
+    reading--;
+
+    for(auto& t : workers)
+    {
+        t.join();
+    }
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    out << finished << " mazes in " << secs << "s, "
+        << (secs > 0 ? finished / secs : 0) << " mazes/s" << endl;
+    return invalid;
+}
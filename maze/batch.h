@@ -0,0 +1,47 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/**
+ * Number of worker threads for each stage of the batch pipeline.
+ */
+struct BatchThreads
+{
+    int gen = 1;
+    int solve = 1;
+    int validate = 1;
+    int render = 1;
+};
+
+/**
+ * Parse thread counts, either one number for every stage
+ * or gen:solve:validate:render (for example 2:4:1:1).
+ *
+ * @return false if the string doesn't make sense
+ */
+bool parse_batch_threads(const string& s, BatchThreads& threads);
+
+/**
+ * Run a batch of jobs through a pipeline:
+ *     generate -> solve -> validate -> render
+ * Each stage has its own worker threads, and the stages are
+ * connected by bounded lock free queues.
+ *
+ * Jobs are read from in, one per line:
+ *     rows cols seed algorithm [render]
+ * where algorithm is dfs, bfs, dij or tour,
+ * and render (0 or 1) prints the solved maze.
+ * Blank lines and lines starting with # are skipped.
+ *
+ * Every job prints one result line to out as it finishes
+ * (not necessarily in order), followed by the total mazes per second.
+ *
+ * @return the number of jobs that didn't produce a valid solution
+ */
+int run_batch(istream& in, ostream& out, const BatchThreads& threads);
+
+#endif // BATCH_H
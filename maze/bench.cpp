@@ -0,0 +1,1091 @@
+#include "maze.h"
+#include "components.h"
+#include "path.h"
+#include "layout.h"
+#include "lockstep.h"
+#include "solvers.h"
+#include "tour.h"
+#include "validate.h"
+#include "scenario.h"
+#include "scheduler.h"
+#include "workspace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////
+//
+// measuring
+//
+////////////////////////////////////////////////////////////////////////
+
+/**
+ * Counts last level cache misses with perf_event_open.
+ * If perf isn't available (containers often don't allow it)
+ * every reading is -1, and available() is false.
+ */
+class CacheMissCounter
+{
+private:
+    int _fd;
+
+public:
+    CacheMissCounter()
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        _fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~CacheMissCounter() { if(_fd >= 0) close(_fd); }
+
+    bool available() const { return _fd >= 0; }
+
+    void start()
+    {
+        if(_fd >= 0)
+        {
+            ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    long long stop()
+    {
+        long long count = -1;
+        if(_fd >= 0)
+        {
+            ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if(read(_fd, &count, sizeof(count)) != sizeof(count))
+            {
+                count = -1;
+            }
+        }
+        return count;
+    }
+};
+
+static double now_ms()
+{
+    using namespace chrono;
+    return duration<double, milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @return the side of the biggest power of 2 square with at most cells rooms
+ *         (the suites that want one big maze use a square this size, seed 1)
+ */
+static int square_side(long long cells)
+{
+    int side = 1;
+    while((long long)(side*2) * (side*2) <= cells)
+    {
+        side *= 2;
+    }
+    return side;
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// layout benchmark
+//
+////////////////////////////////////////////////////////////////////////
+
+// a cache miss count, or n/a if the counter isn't available
+static string misses_text(long long misses)
+{
+    return misses < 0 ? "n/a" : to_string(misses);
+}
+
+/**
+ * Time the real dfs and bfs (the kernel instantiated for the layout),
+ * with the workspace's arrays indexed by the layout too.
+ *
+ * @return if the cache miss counter was available
+ */
+template<class Layout>
+static bool bench_layout(int rows, int cols, unsigned seed, int reps)
+{
+    double t = now_ms();
+    BasicMaze<Layout> m(rows, cols, seed);
+    double gen = now_ms() - t;
+
+    const Layout& L = m.layout();
+    int src = L.index(0, 0);
+    int goal = L.index(rows-1, cols-1);
+    SolverWorkspace ws;
+    CacheMissCounter misses;
+
+    double best[2] = {1e100, 1e100};
+    long long best_misses[2] = {-1, -1};
+    size_t length = 0;
+    for(int i = 0; i < reps; i++)
+    {
+        for(int alg = 0; alg < 2; alg++)
+        {
+            misses.start();
+            t = now_ms();
+            if(alg == 0)
+            {
+                bfs_search(m, ws, src, goal);
+                length = ws.path_size();
+            }
+            else
+            {
+                dfs_search(m, ws, src, goal);
+            }
+            double ms = now_ms() - t;
+            long long miss = misses.stop();
+            if(ms < best[alg])
+            {
+                best[alg] = ms;
+                best_misses[alg] = miss;
+            }
+        }
+    }
+
+    cout << setw(7) << rows << "x" << left << setw(7) << cols << right
+         << setw(13) << Layout::name()
+         << setw(10) << fixed << setprecision(2) << gen
+         << setw(10) << best[0]
+         << setw(13) << misses_text(best_misses[0])
+         << setw(10) << best[1]
+         << setw(13) << misses_text(best_misses[1])
+         << setw(9) << length << endl;
+    return misses.available();
+}
+
+/**
+ * Compare the cell layouts at a few aspect ratios with the same number of rooms.
+ * Every layout gets the same maze (same seed).
+ */
+static void layout_suite(long long cells)
+{
+    const int shapes[][2] = {{1, 1}, {4, 1}, {1, 4}, {1, 256}};
+    cout << "     maze             layout   gen(ms)   bfs(ms)   bfs misses   dfs(ms)   dfs misses   length" << endl;
+    bool counted = true;
+    for(auto [ar, ac] : shapes)
+    {
+        // rows*cols ~= cells with rows:cols = ar:ac
+        int rows = 1;
+        while((long long)(rows*2) * (rows*2) * ac / ar <= cells)
+        {
+            rows *= 2;
+        }
+        int cols = max(1LL, (long long)rows * ac / ar);
+
+        counted = bench_layout<RowMajorLayout>(rows, cols, 1, 3) && counted;
+        counted = bench_layout<TiledLayout<8>>(rows, cols, 1, 3) && counted;
+        counted = bench_layout<TiledLayout<16>>(rows, cols, 1, 3) && counted;
+        counted = bench_layout<MortonLayout>(rows, cols, 1, 3) && counted;
+    }
+    if(!counted)
+    {
+        cout << "(cache misses are n/a: perf_event_open isn't available here)" << endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// repeated solves
+//
+////////////////////////////////////////////////////////////////////////
+
+/**
+ * Solve the same maze over and over,
+ * once with a new workspace and a list path every time (like the old solvers),
+ * and once reusing one workspace.
+ */
+static void repeat_suite(long long cells)
+{
+    int side = square_side(cells);
+    Maze m(side, side, 1);
+    EdgeCosts costs(m);
+    int goal = side*side - 1;
+    int reps = max(1LL, (1LL << 24) / cells);
+
+    cout << side << "x" << side << ", " << reps << " solves each" << endl;
+    cout << "   solver   fresh(ms)  reused(ms)   length" << endl;
+
+    const char* names[] = {"dfs", "bfs", "dijkstra"};
+    for(int alg = 0; alg < 3; alg++)
+    {
+        auto run = [&](SolverWorkspace& ws)
+        {
+            switch(alg)
+            {
+                case 0: dfs_search(m, ws, 0, goal); break;
+                case 1: bfs_search(m, ws, 0, goal); break;
+                case 2: dijkstra_search(costs, ws, 0, goal); break;
+            }
+        };
+
+        size_t total = 0;
+        double t = now_ms();
+        for(int i = 0; i < reps; i++)
+        {
+            SolverWorkspace ws;
+            run(ws);
+            total += ws.path_size();
+        }
+        double fresh = now_ms() - t;
+
+        SolverWorkspace ws;
+        t = now_ms();
+        for(int i = 0; i < reps; i++)
+        {
+            run(ws);
+            total += ws.path_size();
+        }
+        double reused = now_ms() - t;
+
+        // print the average length, so the paths can't be optimized away
+        cout << setw(9) << names[alg]
+             << setw(12) << fixed << setprecision(2) << fresh
+             << setw(12) << reused
+             << setw(9) << total / (2*reps) << endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// kernel against hand written searches
+//
+////////////////////////////////////////////////////////////////////////
+
+// the searches written out by hand, without stats.
+// bfs and dijkstra are the loops the kernel replaced.
+// dfs is not the old backtracking search (that kept the current path on its stack),
+// it's a plain visit-on-push stack search, the same algorithm as StackFrontier,
+// so the comparison is like for like.
+
+static bool dfs_by_hand(const Maze& m, SolverWorkspace& ws, int src, int goal)
+{
+    const int cols = m.columns();
+    ws.begin(size_t(m.rows()) * cols);
+
+    int* stack = ws.queue();
+    size_t top = 0;
+    stack[top++] = src;
+    ws.visit(src);
+    ws.parent(src) = FAIL;
+
+    while(top > 0)
+    {
+        int i = stack[--top];
+        if(i == goal)
+        {
+            ws.trace_path(src, goal, m.layout());
+            return true;
+        }
+
+        int r = i / cols;
+        int c = i % cols;
+        for(int dir = 0; dir < 4; dir++)
+        {
+            if(!m.can_go(dir, r, c))
+            {
+                continue;
+            }
+            auto [dr,dc] = moveIn(dir);
+            int j = i + dr*cols + dc;
+            if(!ws.visited(j))
+            {
+                ws.visit(j);
+                ws.parent(j) = opposite(dir);
+                stack[top++] = j;
+            }
+        }
+    }
+    return false;
+}
+
+static bool bfs_by_hand(const Maze& m, SolverWorkspace& ws, int src, int goal)
+{
+    const int cols = m.columns();
+    ws.begin(size_t(m.rows()) * cols);
+
+    int* queue = ws.queue();
+    size_t head = 0;
+    size_t tail = 0;
+    queue[tail++] = src;
+    ws.visit(src);
+    ws.parent(src) = FAIL;
+
+    while(head < tail)
+    {
+        int i = queue[head++];
+        if(i == goal)
+        {
+            ws.trace_path(src, goal, m.layout());
+            return true;
+        }
+
+        int r = i / cols;
+        int c = i % cols;
+        for(int dir = 0; dir < 4; dir++)
+        {
+            if(!m.can_go(dir, r, c))
+            {
+                continue;
+            }
+            auto [dr,dc] = moveIn(dir);
+            int j = i + dr*cols + dc;
+            if(!ws.visited(j))
+            {
+                ws.visit(j);
+                ws.parent(j) = opposite(dir);
+                queue[tail++] = j;
+            }
+        }
+    }
+    return false;
+}
+
+static bool dijkstra_by_hand(const EdgeCosts& e, SolverWorkspace& ws, int src, int goal)
+{
+    const int cols = e.columns();
+    ws.begin(size_t(e.rows()) * cols);
+
+    int* entry = ws.queue();
+    int* next = ws.link();
+    int used = 0;
+    int head[256];
+    int tail[256];
+    fill(head, head+256, -1);
+    fill(tail, tail+256, -1);
+    size_t pending = 0;
+
+    auto push = [&](int room, uint32_t d)
+    {
+        int b = d & 255;
+        entry[used] = room;
+        next[used] = -1;
+        if(tail[b] < 0)
+        {
+            head[b] = used;
+        }
+        else
+        {
+            next[tail[b]] = used;
+        }
+        tail[b] = used++;
+        pending++;
+    };
+
+    ws.visit(src);
+    ws.dist(src) = 0;
+    ws.parent(src) = FAIL;
+    push(src, 0);
+
+    for(uint32_t d = 0; pending > 0; d++)
+    {
+        int b = d & 255;
+        while(head[b] >= 0)
+        {
+            int x = head[b];
+            head[b] = next[x];
+            if(head[b] < 0)
+            {
+                tail[b] = -1;
+            }
+            pending--;
+
+            int i = entry[x];
+            if(ws.dist(i) != d)
+            {
+                continue;
+            }
+            if(i == goal)
+            {
+                ws.trace_path(src, goal, RowMajorLayout(e.rows(), cols));
+                return true;
+            }
+
+            auto relax = [&](int j, uint8_t w, int back)
+            {
+                if(w != EDGE_WALL && (!ws.visited(j) || d + w < ws.dist(j)))
+                {
+                    ws.visit(j);
+                    ws.dist(j) = d + w;
+                    ws.parent(j) = back;
+                    push(j, d + w);
+                }
+            };
+            relax(i - cols, e.up(i),    DOWN);
+            relax(i - 1,    e.left(i),  RIGHT);
+            relax(i + cols, e.down(i),  UP);
+            relax(i + 1,    e.right(i), LEFT);
+        }
+    }
+    return false;
+}
+
+/**
+ * Time each search written by hand and as a kernel instantiation,
+ * on the same maze with the same workspace.
+ * The paths have to come out the same length.
+ */
+static void kernel_suite(long long cells)
+{
+    int side = square_side(cells);
+    Maze m(side, side, 1);
+    EdgeCosts costs(m);
+    int goal = side*side - 1;
+    int reps = max(2LL, (1LL << 24) / cells);
+
+    cout << side << "x" << side << ", best of " << reps << " solves" << endl;
+    cout << "   solver     hand(ms)   kernel(ms)   ratio   length" << endl;
+
+    SolverWorkspace ws;
+    const char* names[] = {"dfs", "bfs", "dijkstra"};
+    for(int alg = 0; alg < 3; alg++)
+    {
+        auto solve = [&](bool kernel)
+        {
+            double t = now_ms();
+            switch(alg)
+            {
+                case 0: kernel ? dfs_search(m, ws, 0, goal) : dfs_by_hand(m, ws, 0, goal); break;
+                case 1: kernel ? bfs_search(m, ws, 0, goal) : bfs_by_hand(m, ws, 0, goal); break;
+                case 2: kernel ? dijkstra_search(costs, ws, 0, goal)
+                               : dijkstra_by_hand(costs, ws, 0, goal); break;
+            }
+            return now_ms() - t;
+        };
+
+        // take turns going first, so neither one always gets a warm cache
+        double hand = 1e100;
+        double kernel = 1e100;
+        size_t hand_length = 0;
+        size_t kernel_length = 0;
+        for(int i = 0; i < reps; i++)
+        {
+            for(int k = 0; k < 2; k++)
+            {
+                bool use_kernel = (i + k) % 2;
+                double ms = solve(use_kernel);
+                (use_kernel ? kernel : hand) = min(use_kernel ? kernel : hand, ms);
+                (use_kernel ? kernel_length : hand_length) = ws.path_size();
+            }
+        }
+
+        cout << setw(9) << names[alg]
+             << setw(13) << fixed << setprecision(2) << hand
+             << setw(13) << kernel
+             << setw(8) << kernel / hand
+             << setw(9) << kernel_length
+             << (hand_length == kernel_length ? "" : "  (paths differ!)") << endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// component labeling
+//
+////////////////////////////////////////////////////////////////////////
+
+/**
+ * Label a maze with some of its walls put back, with more and more threads,
+ * then answer random reachability queries from the labels and with bfs.
+ */
+static void components_suite(long long cells)
+{
+    int side = square_side(cells);
+    Maze m(side, side, 1);
+    default_random_engine rng(1);
+    uniform_int_distribution<int> room(0, side-1);
+    uniform_int_distribution<int> dir(0, 3);
+    for(long long i = 0; i < cells/8; i++)
+    {
+        m.set_wall(room(rng), room(rng), dir(rng), false);
+    }
+
+    cout << side << "x" << side << " with " << cells/8 << " walls put back" << endl;
+    cout << "  threads   label(ms)   components" << endl;
+    int cores = max(1u, thread::hardware_concurrency());
+    for(int threads = 1; ; threads = min(threads*2, cores))
+    {
+        double best = 1e100;
+        int count = 0;
+        for(int i = 0; i < 3; i++)
+        {
+            double t = now_ms();
+            Components c(m, threads);
+            best = min(best, now_ms() - t);
+            count = c.count();
+        }
+        cout << setw(9) << threads
+             << setw(12) << fixed << setprecision(2) << best
+             << setw(13) << count << endl;
+        if(threads == cores)
+        {
+            break;
+        }
+    }
+
+    Components c(m);
+    SolverWorkspace ws;
+    const int queries = 16;
+    int agree = 0;
+    double label_ms = 0;
+    double bfs_ms = 0;
+    for(int i = 0; i < queries; i++)
+    {
+        point a = make_pair(room(rng), room(rng));
+        point b = make_pair(room(rng), room(rng));
+
+        double t = now_ms();
+        bool by_label = c.connected(a, b);
+        label_ms += now_ms() - t;
+
+        t = now_ms();
+        bool by_bfs = bfs_search(m, ws, a.first*side + a.second, b.first*side + b.second);
+        bfs_ms += now_ms() - t;
+        agree += by_label == by_bfs;
+    }
+    cout << queries << " queries: labels " << setprecision(4) << label_ms << "ms, bfs "
+         << setprecision(2) << bfs_ms << "ms, " << agree << " agree" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// path validation
+//
+////////////////////////////////////////////////////////////////////////
+
+// the corners tour check as it was before the validator:
+// a scan of the path for each corner, a walk to check the steps,
+// and the heights copied out to add up the cost (like print_maze_with_path did)
+static bool valid_tour_by_hand(const Maze& m, const path& p, long long& cost)
+{
+    vector<int> heights;
+    for(auto [r,c] : p)
+    {
+        heights.push_back(m.height(r, c));
+    }
+    cost = 0;
+    for(size_t i = 0; i+1 < heights.size(); i++)
+    {
+        cost += abs(heights[i] - heights[i+1]);
+    }
+
+    auto has = [&](int r, int c) { return find(p.begin(), p.end(), make_pair(r, c)) != p.end(); };
+    if(p.empty() || !has(0, 0) || !has(0, m.columns()-1) ||
+       !has(m.rows()-1, 0) || !has(m.rows()-1, m.columns()-1) ||
+       p.front() != make_pair(m.rows()/2, m.columns()/2) || p.back() != p.front())
+    {
+        return false;
+    }
+    auto it = p.begin();
+    point last = *it;
+    for(it++; it != p.end(); it++)
+    {
+        int dir = direction(*it, last);
+        if(dir == FAIL || !m.can_go(dir, it->first, it->second))
+        {
+            return false;
+        }
+        last = *it;
+    }
+    return true;
+}
+
+/**
+ * Check a long tour (the corners tour walked back and forth)
+ * the old way, with the streaming validator, and split across threads.
+ */
+static void validate_suite(long long cells)
+{
+    int side = square_side(cells);
+    Maze m(side, side, 1);
+    int cost;
+    path tour = solve_waypoint_tour(m, corner_waypoints(side, side), cost);
+
+    // go around the tour forwards and backwards until it's long
+    vector<point> rooms(tour.begin(), tour.end());
+    vector<point> forwards(rooms.begin()+1, rooms.end());
+    vector<point> backwards(rooms.rbegin()+1, rooms.rend());
+    while(rooms.size() < size_t(cells) * 4)
+    {
+        rooms.insert(rooms.end(), backwards.begin(), backwards.end());
+        rooms.insert(rooms.end(), forwards.begin(), forwards.end());
+    }
+    path long_tour(rooms.begin(), rooms.end());
+    vector<point> corners = corner_waypoints(side, side);
+
+    cout << side << "x" << side << ", tour of " << rooms.size() << " rooms" << endl;
+    cout << "                  check   time(ms)   valid        cost" << endl;
+    auto report = [&](const char* name, auto check)
+    {
+        double best = 1e100;
+        bool valid = false;
+        long long cost = 0;
+        for(int i = 0; i < 3; i++)
+        {
+            double t = now_ms();
+            valid = check(cost);
+            best = min(best, now_ms() - t);
+        }
+        cout << setw(23) << name << setw(11) << fixed << setprecision(2) << best
+             << setw(8) << (valid ? "yes" : "no") << setw(12) << cost << endl;
+    };
+    auto one_pass = [&](const PathCheck& check, long long& cost)
+    {
+        cost = check.cost;
+        return is_tour(check, corners[0]);
+    };
+
+    report("list, by hand", [&](long long& cost) { return valid_tour_by_hand(m, long_tour, cost); });
+    report("list, one pass", [&](long long& cost)
+    {
+        return one_pass(check_path(m, long_tour, corners), cost);
+    });
+    report("array, one thread", [&](long long& cost)
+    {
+        return one_pass(check_path(m, rooms.data(), rooms.data() + rooms.size(), corners, 1), cost);
+    });
+    report("array, every core", [&](long long& cost)
+    {
+        return one_pass(check_path(m, rooms.data(), rooms.data() + rooms.size(), corners), cost);
+    });
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// interleaving
+//
+////////////////////////////////////////////////////////////////////////
+
+// median and worst of a list of latencies
+static void print_latencies(const char* name, vector<double> ms)
+{
+    sort(ms.begin(), ms.end());
+    cout << setw(16) << name
+         << setw(12) << fixed << setprecision(3) << ms[ms.size()/2]
+         << setw(12) << ms.back() << endl;
+}
+
+/**
+ * One big dijkstra solve with a pile of small bfs queries behind it,
+ * run to completion one after another and then interleaved by the scheduler.
+ * Then a big solve that's cancelled, and one that runs out of time,
+ * both of which have to leave a valid partial path.
+ */
+static void interleave_suite(long long cells)
+{
+    int side = square_side(cells);
+    const int small = 32;
+    const int queries = 256;
+    const double slice_ms = 0.25;
+
+    Maze big(side, side, 1);
+    EdgeCosts costs(big);
+    int goal = side*side - 1;
+    vector<Maze> mazes;
+    for(int q = 0; q < queries; q++)
+    {
+        mazes.emplace_back(small, small, q+2);
+    }
+    cout << "dijkstra on " << side << "x" << side << ", then " << queries
+         << " bfs queries on " << small << "x" << small
+         << ", " << slice_ms << "ms slices" << endl;
+
+    // one after another: every query waits for the big solve
+    vector<double> serial;
+    SolverWorkspace ws;
+    double start = now_ms();
+    dijkstra_search(costs, ws, 0, goal);
+    double big_serial = now_ms() - start;
+    size_t big_length = ws.path_size();
+    int serial_ok = 0;
+    for(int q = 0; q < queries; q++)
+    {
+        bfs_search(mazes[q], ws, 0, small*small - 1);
+        serial.push_back(now_ms() - start);
+        serial_ok += is_solution(check_path(mazes[q], ws.path_begin(), ws.path_end(), {}, 1), small, small);
+    }
+
+    // interleaved
+    SolveScheduler scheduler(slice_ms);
+    int big_id = scheduler.add(dijkstra_task(costs, 0, goal));
+    vector<int> ids;
+    for(int q = 0; q < queries; q++)
+    {
+        ids.push_back(scheduler.add(bfs_task(mazes[q], 0, small*small - 1)));
+    }
+    scheduler.run();
+
+    vector<double> interleaved;
+    int interleaved_ok = 0;
+    for(int q = 0; q < queries; q++)
+    {
+        interleaved.push_back(scheduler.latency_ms(ids[q]));
+        bool found = scheduler.state(ids[q]) == JobState::FOUND;
+        // done with the job, so its workspace can go
+        unique_ptr<SolveTask> task = scheduler.release(ids[q]);
+        const SolverWorkspace& qws = task->workspace();
+        interleaved_ok += found && is_solution(check_path(mazes[q], qws.path_begin(), qws.path_end(), {}, 1), small, small);
+    }
+    const SolverWorkspace& bws = scheduler.task(big_id).workspace();
+
+    cout << "   query latency  median(ms)    worst(ms)" << endl;
+    print_latencies("serial", serial);
+    print_latencies("interleaved", interleaved);
+    cout << "big solve: " << setprecision(2) << big_serial << "ms alone, "
+         << scheduler.latency_ms(big_id) << "ms interleaved over "
+         << scheduler.slices(big_id) << " slices, length "
+         << bws.path_size() << (bws.path_size() == big_length ? "" : " (differs!)") << endl;
+    cout << "valid query paths: " << serial_ok << " serial, " << interleaved_ok << " interleaved" << endl;
+
+    // stopped early, the best partial path still has to be a real path from the start
+    auto report_partial = [&](const char* how, const SolveScheduler& s, int id)
+    {
+        const SolverWorkspace& pws = s.task(id).workspace();
+        PathCheck check = check_path(big, pws.path_begin(), pws.path_end(), {}, 1);
+        point end = check.back;
+        cout << how << " after " << setprecision(2) << s.latency_ms(id) << "ms: partial path of "
+             << check.rooms << " rooms to (" << end.first << "," << end.second << "), "
+             << (check.valid && check.front == make_pair(0, 0) ? "valid" : "INVALID") << endl;
+    };
+
+    SolveScheduler cancelling(slice_ms);
+    int cancel_id = cancelling.add(dijkstra_task(costs, 0, goal));
+    for(int i = 0; i < 8; i++)
+    {
+        cancelling.run_once();
+    }
+    cancelling.cancel(cancel_id);
+    report_partial("cancelled", cancelling, cancel_id);
+
+    SolveScheduler deadline(slice_ms);
+    int deadline_id = deadline.add(dijkstra_task(costs, 0, goal), big_serial / 4);
+    deadline.run();
+    report_partial(deadline.state(deadline_id) == JobState::TIMED_OUT ? "timed out" : "finished",
+                   deadline, deadline_id);
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// lockstep batches
+//
+////////////////////////////////////////////////////////////////////////
+
+/**
+ * Lots of small mazes solved with bfs one at a time and in lockstep batches,
+ * 8 and 16 to a batch. Both sides hand back every path as a list.
+ * Every lockstep path has to pass valid_solution and be as short as the scalar one.
+ */
+static void lockstep_suite(long long cells)
+{
+    cout << "   size    mazes   scalar(maze/s)   x8(maze/s)  x16(maze/s)   speedup   valid" << endl;
+    for(int side : {8, 16, 32, 64})
+    {
+        int count = max(256LL, cells / (side*side)) / 16 * 16;
+        vector<Maze> mazes;
+        for(int i = 0; i < count; i++)
+        {
+            mazes.emplace_back(side, side, i+1);
+        }
+        int goal = side*side - 1;
+        const int reps = 3;
+
+        SolverWorkspace ws;
+        vector<size_t> lengths(count);
+        double scalar = 1e100;
+        for(int rep = 0; rep < reps; rep++)
+        {
+            double t = now_ms();
+            for(int i = 0; i < count; i++)
+            {
+                bfs_search(mazes[i], ws, 0, goal);
+                lengths[i] = ws.to_list().size();
+            }
+            scalar = min(scalar, now_ms() - t);
+        }
+
+        LockstepBatch batch(side, side);
+        int valid = 0;
+        double lockstep[2] = {1e100, 1e100};
+        for(int w = 0; w < 2; w++)
+        {
+            int width = w == 0 ? 8 : 16;
+            for(int rep = 0; rep < reps; rep++)
+            {
+                int ok = 0;
+                double t = now_ms();
+                for(int i = 0; i < count; i += width)
+                {
+                    batch.clear();
+                    for(int l = 0; l < width; l++)
+                    {
+                        batch.add(mazes[i+l]);
+                    }
+                    batch.solve_bfs(0, goal);
+                    for(int l = 0; l < width; l++)
+                    {
+                        path p = batch.solution(l);
+                        ok += p.size() == lengths[i+l];
+                    }
+                }
+                lockstep[w] = min(lockstep[w], now_ms() - t);
+                if(rep == 0 && w == 1)
+                {
+                    valid = ok;
+                }
+            }
+        }
+
+        // the timed runs only compare lengths, check the paths themselves once
+        for(int i = 0; i < count; i += 16)
+        {
+            batch.clear();
+            for(int l = 0; l < 16; l++)
+            {
+                batch.add(mazes[i+l]);
+            }
+            batch.solve_bfs(0, goal);
+            for(int l = 0; l < 16; l++)
+            {
+                valid -= !valid_solution(mazes[i+l], batch.solution(l));
+            }
+        }
+
+        cout << setw(4) << side << "x" << left << setw(4) << side << right
+             << setw(7) << count
+             << setw(17) << fixed << setprecision(0) << count / scalar * 1000
+             << setw(13) << count / lockstep[0] * 1000
+             << setw(13) << count / lockstep[1] * 1000
+             << setw(10) << setprecision(2) << scalar / lockstep[1]
+             << setw(8) << valid << endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// scenario suite
+//
+////////////////////////////////////////////////////////////////////////
+
+/**
+ * One solver on one maze.
+ */
+struct SuiteResult
+{
+    string key;     // scenario,rows,cols,solver
+    double ms;
+    size_t length;
+    long long cost;
+};
+
+/**
+ * Read a baseline written by the suite.
+ * Bad lines are skipped.
+ */
+static map<string, SuiteResult> read_baseline(const string& filename)
+{
+    map<string, SuiteResult> baseline;
+    ifstream in(filename);
+    string line;
+    getline(in, line);  // header
+    while(getline(in, line))
+    {
+        // the key is everything before the fourth comma
+        size_t pos = 0;
+        for(int i = 0; i < 4 && pos != string::npos; i++)
+        {
+            pos = line.find(',', pos+1);
+        }
+        if(pos == string::npos)
+        {
+            continue;
+        }
+        SuiteResult r;
+        r.key = line.substr(0, pos);
+        char comma;
+        stringstream fields(line.substr(pos+1));
+        if(fields >> r.ms >> comma >> r.length >> comma >> r.cost)
+        {
+            baseline[r.key] = r;
+        }
+    }
+    return baseline;
+}
+
+/**
+ * Run every solver over every scenario at three sizes (cells/256, cells/16 and cells).
+ * Each time is the best of a few runs on the same maze.
+ *
+ * @param mode "save" writes the results to file as a baseline,
+ *             "compare" reads the baseline in file and shows the change
+ */
+static void scenario_suite_bench(long long cells, const string& mode, const string& file)
+{
+    map<string, SuiteResult> baseline;
+    if(mode == "compare")
+    {
+        baseline = read_baseline(file);
+        if(baseline.empty())
+        {
+            cerr << "no baseline in " << file << endl;
+            return;
+        }
+    }
+
+    vector<SuiteResult> results;
+    cout << "     scenario        maze       solver     time(ms)   length       cost"
+         << (mode == "compare" ? "   vs base" : "") << endl;
+    for(auto& scenario : scenario_suite())
+    {
+        for(long long size : {max(16LL, cells / 256), max(16LL, cells / 16), cells})
+        {
+            int rows, cols;
+            scenario_shape(scenario, size, rows, cols);
+            Maze m(rows, cols, 1, scenario.params);
+            EdgeCosts costs(m);
+            int goal = rows*cols - 1;
+            int reps = max(3LL, min(50LL, (1LL << 20) / size));
+            SolverWorkspace ws;
+
+            const char* names[] = {"dfs", "bfs", "dijkstra", "tour"};
+            for(int alg = 0; alg < 4; alg++)
+            {
+                path tour;
+                double best = 1e100;
+                for(int i = 0; i < reps; i++)
+                {
+                    double t = now_ms();
+                    int tour_cost;
+                    switch(alg)
+                    {
+                        case 0: dfs_search(m, ws, 0, goal); break;
+                        case 1: bfs_search(m, ws, 0, goal); break;
+                        case 2: dijkstra_search(costs, ws, 0, goal); break;
+                        case 3: tour = solve_waypoint_tour(m, corner_waypoints(rows, cols), tour_cost); break;
+                    }
+                    best = min(best, now_ms() - t);
+                }
+                PathCheck check = alg == 3 ? check_path(m, tour)
+                                           : check_path(m, ws.path_begin(), ws.path_end());
+
+                SuiteResult r;
+                r.key = scenario.name + "," + to_string(rows) + "," + to_string(cols) + "," + names[alg];
+                r.ms = best;
+                r.length = check.rooms;
+                r.cost = check.cost;
+                results.push_back(r);
+
+                cout << setw(13) << scenario.name
+                     << setw(7) << rows << "x" << left << setw(7) << cols << right
+                     << setw(9) << names[alg]
+                     << setw(13) << fixed << setprecision(3) << r.ms
+                     << setw(9) << r.length
+                     << setw(11) << r.cost;
+                if(mode == "compare")
+                {
+                    auto it = baseline.find(r.key);
+                    if(it == baseline.end())
+                    {
+                        cout << "       new";
+                    }
+                    else
+                    {
+                        cout << setw(9) << setprecision(2) << r.ms / max(1e-6, it->second.ms) << "x";
+                        if(it->second.length != r.length || it->second.cost != r.cost)
+                        {
+                            cout << "  (path changed)";
+                        }
+                    }
+                }
+                cout << endl;
+            }
+        }
+    }
+
+    if(mode == "save")
+    {
+        ofstream out(file);
+        out << "scenario,rows,cols,solver,ms,length,cost\n";
+        for(auto& r : results)
+        {
+            out << r.key << "," << r.ms << "," << r.length << "," << r.cost << "\n";
+        }
+        cout << "saved " << results.size() << " results to " << file << endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        cerr << "usage:\n"
+             << "./maze_bench option [cells]\n"
+             << "./maze_bench suite [cells [save|compare baseline.csv]]\n"
+             << " options:\n"
+             << "  layout: dfs and bfs time and cache misses for each cell layout\n"
+             << "  repeat: repeated solves with fresh and reused workspaces\n"
+             << "  kernel: the search kernel against hand written searches\n"
+             << "  components: parallel component labeling and reachability queries\n"
+             << "  validate: checking a long tour, by hand, in one pass and in chunks\n"
+             << "  interleave: small queries behind a big solve, in order and interleaved\n"
+             << "  lockstep: lots of small mazes, one at a time and in lockstep batches\n"
+             << "  suite: every solver over the scenario suite" << endl;
+        return 0;
+    }
+    string opt(argv[1]);
+    long long cells = argc > 2 ? atoll(argv[2]) : 1 << 22;
+
+    if(opt == "layout")
+    {
+        layout_suite(cells);
+    }
+    if(opt == "repeat")
+    {
+        repeat_suite(cells);
+    }
+    if(opt == "kernel")
+    {
+        kernel_suite(cells);
+    }
+    if(opt == "components")
+    {
+        components_suite(cells);
+    }
+    if(opt == "validate")
+    {
+        validate_suite(cells);
+    }
+    if(opt == "interleave")
+    {
+        interleave_suite(cells);
+    }
+    if(opt == "lockstep")
+    {
+        lockstep_suite(cells);
+    }
+    if(opt == "suite")
+    {
+        scenario_suite_bench(cells, argc > 4 ? argv[3] : "", argc > 4 ? argv[4] : "");
+    }
+}
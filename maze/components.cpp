@@ -0,0 +1,194 @@
+#include "components.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// don't split the rows into bands thinner than this
+const int MIN_BAND_ROWS = 16;
+
+/**
+ * find the set a room belongs to.
+ * Uses path halving, and a halving step that loses a race is just skipped,
+ * since the parent it saw is still an ancestor.
+ */
+static int find_set(atomic<int>* parent, int x)
+{
+    while(true)
+    {
+        int p = parent[x].load(memory_order_relaxed);
+        if(p == x)
+        {
+            return x;
+        }
+        int gp = parent[p].load(memory_order_relaxed);
+        if(gp != p)
+        {
+            parent[x].compare_exchange_weak(p, gp, memory_order_relaxed);
+        }
+        x = gp;
+    }
+}
+
+/**
+ * merge the sets of a and b without locks.
+ * The larger root is always linked under the smaller one,
+ * so the sets can't form a cycle, and the root of a set is its first room.
+ * If another thread links the root first, the CAS fails and we look again.
+ */
+static void union_sets(atomic<int>* parent, int a, int b)
+{
+    while(true)
+    {
+        a = find_set(parent, a);
+        b = find_set(parent, b);
+        if(a == b)
+        {
+            return;
+        }
+        if(a < b)
+        {
+            swap(a, b);
+        }
+        int root = a;
+        if(parent[a].compare_exchange_strong(root, b, memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * run f(band, first row, one past the last row) for every band at once,
+ * and wait for all of them
+ */
+static void for_each_band(const vector<int>& bands, const function<void(int,int,int)>& f)
+{
+    int n = bands.size() - 1;
+    vector<thread> threads;
+    for(int b = 1; b < n; b++)
+    {
+        threads.emplace_back(f, b, bands[b], bands[b+1]);
+    }
+    f(0, bands[0], bands[1]);
+    for(auto& t : threads)
+    {
+        t.join();
+    }
+}
+
+/**
+ * Label the components in five passes, each one split over the bands:
+ *   1. join the rooms inside each band
+ *   2. join each band to the one above it, across the border
+ *   3. point every room straight at its root, and count the roots
+ *   4. number the roots, in order
+ *   5. every room takes its root's number
+ */
+Components::Components(const Maze& m, int threads)
+    : _rows(m.rows()), _cols(m.columns()), _count(0), _label(size_t(_rows)*_cols)
+{
+    if(threads <= 0)
+    {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    int nbands = max(1, min(threads, _rows / MIN_BAND_ROWS));
+
+    vector<int> bands(nbands+1);
+    for(int b = 0; b <= nbands; b++)
+    {
+        bands[b] = int(int64_t(_rows) * b / nbands);
+    }
+
+    const int cols = _cols;
+    unique_ptr<atomic<int>[]> sets(new atomic<int>[_label.size()]);
+    atomic<int>* parent = sets.get();
+
+    for_each_band(bands, [&](int, int r0, int r1)
+    {
+        for(int i = r0*cols; i < r1*cols; i++)
+        {
+            parent[i].store(i, memory_order_relaxed);
+        }
+        for(int r = r0; r < r1; r++)
+        {
+            for(int c = 0; c < cols; c++)
+            {
+                int i = r*cols + c;
+                if(m.can_go_right(r, c))
+                {
+                    union_sets(parent, i, i+1);
+                }
+                if(r+1 < r1 && m.can_go_down(r, c))
+                {
+                    union_sets(parent, i, i+cols);
+                }
+            }
+        }
+    });
+
+    for_each_band(bands, [&](int, int r0, int)
+    {
+        if(r0 == 0)
+        {
+            return;
+        }
+        for(int c = 0; c < cols; c++)
+        {
+            if(m.can_go_down(r0-1, c))
+            {
+                union_sets(parent, (r0-1)*cols + c, r0*cols + c);
+            }
+        }
+    });
+
+    vector<int> roots(nbands+1, 0);
+    for_each_band(bands, [&](int b, int r0, int r1)
+    {
+        int count = 0;
+        for(int i = r0*cols; i < r1*cols; i++)
+        {
+            int root = find_set(parent, i);
+            parent[i].store(root, memory_order_relaxed);
+            count += root == i;
+        }
+        roots[b+1] = count;
+    });
+    for(int b = 0; b < nbands; b++)
+    {
+        roots[b+1] += roots[b];
+    }
+    _count = roots[nbands];
+
+    for_each_band(bands, [&](int b, int r0, int r1)
+    {
+        int next = roots[b];
+        for(int i = r0*cols; i < r1*cols; i++)
+        {
+            if(parent[i].load(memory_order_relaxed) == i)
+            {
+                _label[i] = next++;
+            }
+        }
+    });
+
+    // a root comes before the rest of its component,
+    // but it can be in an earlier band, so this has to be its own pass.
+    // Roots already have their numbers and aren't written again.
+    for_each_band(bands, [&](int, int r0, int r1)
+    {
+        for(int i = r0*cols; i < r1*cols; i++)
+        {
+            int root = parent[i].load(memory_order_relaxed);
+            if(root != i)
+            {
+                _label[i] = _label[root];
+            }
+        }
+    });
+}
@@ -0,0 +1,61 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include "maze.h"
+#include "path.h"
+#include <vector>
+
+using namespace std;
+
+/**
+ * The connected components of a maze, so "can a reach b"
+ * is one comparison instead of a search.
+ *
+ * Components are numbered 0 to count()-1 in the order of their
+ * first room (row major), so the component holding (0,0) is 0.
+ * The labels are a snapshot, they have to be rebuilt if walls change.
+ */
+class Components
+{
+private:
+    int _rows;
+    int _cols;
+    int _count;
+    vector<int> _label;
+
+public:
+    /**
+     * Label the maze with a union-find over its open walls.
+     * The rows are split into bands, each thread joins the rooms in its own band,
+     * then the bands are merged across their borders with lock free unions.
+     *
+     * @param threads number of threads, 0 for one per core
+     */
+    explicit Components(const Maze& m, int threads = 0);
+
+    int rows() const    { return _rows; }
+    int columns() const { return _cols; }
+
+    /**
+     * @return the number of components
+     */
+    int count() const { return _count; }
+
+    /**
+     * @return the component of room (r,c)
+     */
+    int id(int r, int c) const     { return _label[size_t(r)*_cols + c]; }
+    int id(const point& p) const   { return id(p.first, p.second); }
+
+    /**
+     * @return if there's a path between a and b
+     */
+    bool connected(const point& a, const point& b) const { return id(a) == id(b); }
+
+    /**
+     * @return the component of every room, numbered r*cols + c
+     */
+    const int* labels() const { return _label.data(); }
+};
+
+#endif // COMPONENTS_H
@@ -0,0 +1,42 @@
+#include "edge_costs.h"
+
+using namespace std;
+
+EdgeCosts::EdgeCosts(int rows, int cols)
+    : _rows(rows), _cols(cols),
+      _right_plane(size_t(rows+1) * cols, EDGE_WALL),
+      _down_plane(size_t(rows+1) * cols, EDGE_WALL),
+      _right(_right_plane.data() + cols),
+      _down(_down_plane.data() + cols)
+{
+}
+
+/**
+ * Compute one row of edge costs.
+ * The open flags are 0xFF or 0, so a wall ors the cost up to EDGE_WALL.
+ * There are no branches, so the compiler can vectorize the loop.
+ *
+ * @param h heights of this row
+ * @param hn heights of the next row (anything for the last row)
+ * @param right_open 0xFF if we can go right
+ * @param down_open 0xFF if we can go down
+ */
+void EdgeCosts::build_row(const int* __restrict h, const int* __restrict hn,
+                          const uint8_t* __restrict right_open, const uint8_t* __restrict down_open,
+                          int cols, uint8_t* __restrict right, uint8_t* __restrict down)
+{
+    for(int c = 0; c+1 < cols; c++)
+    {
+        int d = h[c] - h[c+1];
+        d = d < 0 ? -d : d;
+        right[c] = uint8_t(d) | uint8_t(~right_open[c]);
+    }
+    right[cols-1] = EDGE_WALL;
+
+    for(int c = 0; c < cols; c++)
+    {
+        int d = h[c] - hn[c];
+        d = d < 0 ? -d : d;
+        down[c] = uint8_t(d) | uint8_t(~down_open[c]);
+    }
+}
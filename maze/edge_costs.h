@@ -0,0 +1,100 @@
+#ifndef EDGE_COSTS_H
+#define EDGE_COSTS_H
+
+#include "maze.h"
+#include "path.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// edge cost used for walls
+const uint8_t EDGE_WALL = 0xFF;
+
+/**
+ * Precomputed cost of every edge in a maze, as two flat uint8_t planes.
+ * right(i) is the cost of going right from room i, down(i) is going down.
+ * Left and up are the right and down costs of the neighbor.
+ * Rooms are numbered r*cols + c.
+ *
+ * Walls are EDGE_WALL, so heights have to be within 254 of each other.
+ * The heights themselves can be anything, only their differences are narrowed to a byte.
+ *
+ * Both planes have a row of walls in front of them,
+ * so looking left from column 0 or up from row 0 finds a wall
+ * without checking the bounds.
+ */
+class EdgeCosts
+{
+private:
+    int _rows;
+    int _cols;
+    vector<uint8_t> _right_plane;
+    vector<uint8_t> _down_plane;
+    uint8_t* _right;
+    uint8_t* _down;
+
+    EdgeCosts(int rows, int cols);
+
+    static void build_row(const int* h, const int* hn,
+                          const uint8_t* right_open, const uint8_t* down_open,
+                          int cols, uint8_t* right, uint8_t* down);
+
+public:
+    /**
+     * Build the planes for a maze.
+     * The rooms are read once through the maze's accessors,
+     * and then each row of costs is computed without branches.
+     */
+    template<class Layout>
+    EdgeCosts(const BasicMaze<Layout>& m) : EdgeCosts(m.rows(), m.columns())
+    {
+        vector<int> h(_cols), hn(_cols);
+        vector<uint8_t> right_open(_cols), down_open(_cols);
+        for(int c = 0; c < _cols; c++)
+        {
+            hn[c] = m.height(0, c);
+        }
+        for(int r = 0; r < _rows; r++)
+        {
+            h.swap(hn);
+            for(int c = 0; c < _cols; c++)
+            {
+                hn[c] = r+1 < _rows ? m.height(r+1, c) : 0;
+                right_open[c] = m.can_go_right(r, c) ? 0xFF : 0;
+                down_open[c] = m.can_go_down(r, c) ? 0xFF : 0;
+            }
+            build_row(h.data(), hn.data(), right_open.data(), down_open.data(),
+                      _cols, _right + size_t(r)*_cols, _down + size_t(r)*_cols);
+        }
+    }
+
+    int rows() const    { return _rows; }
+    int columns() const { return _cols; }
+
+    uint8_t right(size_t i) const { return _right[i]; }
+    uint8_t down(size_t i) const  { return _down[i]; }
+    uint8_t left(size_t i) const  { return _right[i-1]; }
+    uint8_t up(size_t i) const    { return _down[i-_cols]; }
+
+    // the planes themselves, starting at room 0
+    const uint8_t* right_plane() const { return _right; }
+    const uint8_t* down_plane() const  { return _down; }
+
+    /**
+     * @return the cost of going from room i in direction dir, or EDGE_WALL
+     */
+    uint8_t cost(size_t i, int dir) const
+    {
+        switch(dir)
+        {
+            case UP:    return up(i);
+            case LEFT:  return left(i);
+            case DOWN:  return down(i);
+            case RIGHT: return right(i);
+        }
+        return EDGE_WALL;
+    }
+};
+
+#endif // EDGE_COSTS_H
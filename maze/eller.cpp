@@ -0,0 +1,156 @@
+#include "eller.h"
+#include "mazefile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// write the output in chunks of about this many bytes
+const size_t WRITE_CHUNK = 4 << 20;
+
+/**
+ * find the set a label belongs to.
+ * Uses path halving so the sets stay shallow.
+ */
+static int find_set(vector<int>& parent, int x)
+{
+    while(parent[x] != x)
+    {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+/**
+ * Generate a maze one row at a time with Eller's algorithm.
+ *
+ * For every row:
+ *   1. randomly knock down walls between neighbors in different sets,
+ *      and merge the sets (the last row merges everything).
+ *   2. every set gets at least one room that goes down,
+ *      so nothing gets cut off from the rest of the maze.
+ *   3. rooms that went down keep their set in the next row,
+ *      everything else starts a new set.
+ */
+bool gen_eller_file(const string& filename, int64_t rows, int64_t cols,
+                    unsigned seed, double frac)
+{
+    ofstream out(filename, ios::binary | ios::trunc);
+    if(!out || rows <= 0 || cols <= 0)
+    {
+        return false;
+    }
+
+    MazeFileHeader header;
+    memcpy(header.magic, MAZE_ROWS_MAGIC, sizeof(header.magic));
+    header.rows = rows;
+    header.cols = cols;
+    header.tile = 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    default_random_engine rng(seed);
+    bernoulli_distribution coin(0.5);
+    bernoulli_distribution extra(frac);
+    uniform_int_distribution<int> height(0, 9);
+
+    // set labels are always compacted to [0, cols)
+    vector<int> label(cols);
+    vector<int> parent(cols);
+    vector<int> remaining(cols);
+    vector<bool> has_down(cols);
+    vector<int> remap(cols);
+    iota(label.begin(), label.end(), 0);
+
+    // buffer whole rows, so we write in big sequential chunks
+    size_t rows_per_chunk = max<size_t>(1, WRITE_CHUNK / cols);
+    vector<unsigned char> buffer(rows_per_chunk * cols);
+    size_t used = 0;
+
+    for(int64_t r = 0; r < rows; r++)
+    {
+        bool last = r == rows-1;
+        unsigned char* row = &buffer[used];
+
+        for(int64_t c = 0; c < cols; c++)
+        {
+            row[c] = height(rng) << CELL_HEIGHT_SHIFT;
+        }
+
+        // join neighbors
+        iota(parent.begin(), parent.end(), 0);
+        for(int64_t c = 0; c+1 < cols; c++)
+        {
+            int a = find_set(parent, label[c]);
+            int b = find_set(parent, label[c+1]);
+            if(a != b ? (last || coin(rng)) : extra(rng))
+            {
+                row[c] |= CELL_RIGHT;
+                parent[b] = a;
+            }
+        }
+
+        if(!last)
+        {
+            fill(remaining.begin(), remaining.end(), 0);
+            fill(has_down.begin(), has_down.end(), false);
+            for(int64_t c = 0; c < cols; c++)
+            {
+                label[c] = find_set(parent, label[c]);
+                remaining[label[c]]++;
+            }
+
+            // go down randomly, but the last room in a set always goes down
+            // if nothing else in the set did
+            for(int64_t c = 0; c < cols; c++)
+            {
+                int s = label[c];
+                remaining[s]--;
+                if(coin(rng) || (remaining[s] == 0 && !has_down[s]) || extra(rng))
+                {
+                    row[c] |= CELL_DOWN;
+                    has_down[s] = true;
+                }
+            }
+
+            // compact the labels for the next row
+            fill(remap.begin(), remap.end(), -1);
+            int next = 0;
+            for(int64_t c = 0; c < cols; c++)
+            {
+                if(row[c] & CELL_DOWN)
+                {
+                    if(remap[label[c]] < 0)
+                    {
+                        remap[label[c]] = next++;
+                    }
+                    label[c] = remap[label[c]];
+                }
+                else
+                {
+                    label[c] = -1;
+                }
+            }
+            for(int64_t c = 0; c < cols; c++)
+            {
+                if(label[c] < 0)
+                {
+                    label[c] = next++;
+                }
+            }
+        }
+
+        used += cols;
+        if(used == buffer.size() || last)
+        {
+            out.write(reinterpret_cast<const char*>(buffer.data()), used);
+            used = 0;
+        }
+    }
+
+    return bool(out);
+}
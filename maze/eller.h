@@ -0,0 +1,31 @@
+#ifndef ELLER_H
+#define ELLER_H
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+/**
+ * Generate a random maze straight to a row file (see mazefile.h)
+ * using Eller's algorithm.
+ *
+ * Eller's algorithm only needs the set labels for the current row,
+ * so memory use is O(cols) no matter how many rows there are.
+ * Rows are packed into a large buffer and written out sequentially.
+ *
+ * With frac = 0 the maze is perfect (exactly one path between any two rooms).
+ * Otherwise each wall that would have been kept is deleted
+ * with probability frac, like Maze::delete_walls.
+ *
+ * @param filename the file to write
+ * @param rows number of rows
+ * @param cols number of columns
+ * @param seed seed for the random number generator
+ * @param frac fraction of extra walls to delete
+ * @return false if the file couldn't be written
+ */
+bool gen_eller_file(const string& filename, int64_t rows, int64_t cols,
+                    unsigned seed, double frac = 0.1);
+
+#endif // ELLER_H
@@ -0,0 +1,456 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include "maze.h"
+#include "path.h"
+#include "layout.h"
+#include "edge_costs.h"
+#include "workspace.h"
+#include "stats.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+
+using namespace std;
+
+/**
+ * One search loop for every solver, put together at compile time from
+ *   a frontier: which room to look at next (stack, FIFO or buckets)
+ *   a cost model: what each edge costs, or EDGE_WALL
+ *   a goal test: when to stop
+ *
+ * The policies are plain classes, so everything inlines,
+ * and the four directions are unrolled with the direction as a constant.
+ */
+
+////////////////////////////////////////////////////////////////////////
+//
+// frontiers
+//
+////////////////////////////////////////////////////////////////////////
+
+/**
+ * A frontier keeps its entries in the workspace's queue (and link) arrays.
+ *
+ *   REOPEN       if a visited room can be pushed again with a lower cost
+ *   push(i, d)   add room i, reached with cost d
+ *   pop()        take the next room
+ *   cost()       the cost the room just popped was pushed with
+ *                (only needed with REOPEN)
+ *
+ * Rooms without REOPEN are marked visited when they're pushed,
+ * so each one goes in once, and the kernel doesn't keep their costs.
+ */
+
+// last in first out, for depth first search
+class StackFrontier
+{
+private:
+    int* _stack;
+    size_t _top;
+
+public:
+    static constexpr bool REOPEN = false;
+
+    explicit StackFrontier(SolverWorkspace& ws) : _stack(ws.queue()), _top(0) {}
+
+    bool empty() const            { return _top == 0; }
+    size_t size() const           { return _top; }
+    void push(int room, uint32_t) { _stack[_top++] = room; }
+    int pop()                     { return _stack[--_top]; }
+};
+
+// first in first out, for breadth first search
+class FifoFrontier
+{
+private:
+    int* _queue;
+    size_t _head;
+    size_t _tail;
+
+public:
+    static constexpr bool REOPEN = false;
+
+    explicit FifoFrontier(SolverWorkspace& ws) : _queue(ws.queue()), _head(0), _tail(0) {}
+
+    bool empty() const            { return _head == _tail; }
+    size_t size() const           { return _tail - _head; }
+    void push(int room, uint32_t) { _queue[_tail++] = room; }
+    int pop()                     { return _queue[_head++]; }
+};
+
+/**
+ * Dial's buckets: a ring of 256, since no edge costs more than 254.
+ * The buckets are linked lists threaded through the workspace's queue and link arrays.
+ * A room can be in the buckets more than once,
+ * the kernel skips the copies with an out of date cost.
+ */
+class BucketFrontier
+{
+private:
+    int* _entry;
+    int* _next;
+    int _used;
+    int _head[256];
+    int _tail[256];
+    size_t _pending;
+    uint32_t _d;    // cost of the bucket being emptied
+
+public:
+    static constexpr bool REOPEN = true;
+
+    explicit BucketFrontier(SolverWorkspace& ws)
+        : _entry(ws.queue()), _next(ws.link()), _used(0), _pending(0), _d(0)
+    {
+        fill(_head, _head+256, -1);
+        fill(_tail, _tail+256, -1);
+    }
+
+    bool empty() const  { return _pending == 0; }
+    size_t size() const { return _pending; }
+
+    void push(int room, uint32_t d)
+    {
+        int b = d & 255;
+        _entry[_used] = room;
+        _next[_used] = -1;
+        if(_tail[b] < 0)
+        {
+            _head[b] = _used;
+        }
+        else
+        {
+            _next[_tail[b]] = _used;
+        }
+        _tail[b] = _used++;
+        _pending++;
+    }
+
+    int pop()
+    {
+        // rooms reached with a zero cost edge go in the bucket we're emptying
+        while(_head[_d & 255] < 0)
+        {
+            _d++;
+        }
+        int b = _d & 255;
+        int x = _head[b];
+        _head[b] = _next[x];
+        if(_head[b] < 0)
+        {
+            _tail[b] = -1;
+        }
+        _pending--;
+        return _entry[x];
+    }
+
+    uint32_t cost() const { return _d; }
+};
+
+////////////////////////////////////////////////////////////////////////
+//
+// cost models
+//
+////////////////////////////////////////////////////////////////////////
+
+/**
+ * A cost model says how the rooms are laid out and what each edge costs:
+ *   Layout, layout()       the rooms' layout (see layout.h),
+ *                          rooms are numbered by their index in it
+ *   weight<DIR>(i, r, c)   the cost of leaving room i (at r,c) in direction DIR,
+ *                          or EDGE_WALL
+ * The kernel only works out r and c if the cost model or the layout NEEDS_RC.
+ */
+
+// every open edge costs 1, read straight from the maze's walls.
+// UnitCost is for the row major Maze.
+template<class L>
+class BasicUnitCost
+{
+private:
+    const BasicMaze<L>& _m;
+
+public:
+    using Layout = L;
+    static constexpr bool NEEDS_RC = true;
+
+    explicit BasicUnitCost(const BasicMaze<L>& m) : _m(m) {}
+
+    const Layout& layout() const { return _m.layout(); }
+
+    template<int DIR>
+    uint8_t weight(int, int r, int c) const
+    {
+        return _m.can_go(DIR, r, c) ? 1 : EDGE_WALL;
+    }
+};
+
+using UnitCost = BasicUnitCost<RowMajorLayout>;
+
+// edges cost the height difference, from the edge cost planes
+class HeightCost
+{
+private:
+    // copies of the planes, so the kernel can keep them in registers
+    RowMajorLayout _layout;
+    int _cols;
+    const uint8_t* _right;
+    const uint8_t* _down;
+
+public:
+    using Layout = RowMajorLayout;
+    static constexpr bool NEEDS_RC = false;
+
+    explicit HeightCost(const EdgeCosts& e)
+        : _layout(e.rows(), e.columns()), _cols(e.columns()),
+          _right(e.right_plane()), _down(e.down_plane()) {}
+
+    const Layout& layout() const { return _layout; }
+
+    template<int DIR>
+    uint8_t weight(int i, int, int) const
+    {
+        if constexpr(DIR == UP)   return _down[i - _cols];
+        if constexpr(DIR == LEFT) return _right[i - 1];
+        if constexpr(DIR == DOWN) return _down[i];
+        return _right[i];
+    }
+};
+
+////////////////////////////////////////////////////////////////////////
+//
+// goal tests
+//
+////////////////////////////////////////////////////////////////////////
+
+// stop at one room (a goal of -1 never matches)
+struct RoomGoal
+{
+    int goal;
+    bool operator()(int i) const { return i == goal; }
+};
+
+// search everything
+struct NoGoal
+{
+    bool operator()(int) const { return false; }
+};
+
+////////////////////////////////////////////////////////////////////////
+//
+// the kernel
+//
+////////////////////////////////////////////////////////////////////////
+
+/**
+ * call f(integral_constant<int, dir>) for each direction,
+ * so the direction is a constant in every copy of f's body
+ */
+template<class F>
+inline void for_each_dir(F&& f)
+{
+    f(integral_constant<int, UP>());
+    f(integral_constant<int, LEFT>());
+    f(integral_constant<int, DOWN>());
+    f(integral_constant<int, RIGHT>());
+}
+
+// where a search has got to
+enum class SearchStatus
+{
+    RUNNING,    // there's more to do
+    FOUND,      // reached a goal, the path is in the workspace
+    EXHAUSTED   // everything reachable has been seen, and no goal
+};
+
+/**
+ * A search that can be run a little at a time.
+ * All of its state is in the object and the workspace,
+ * so step() can stop after any number of rooms and pick up where it left off.
+ * Rooms are numbered by their index in the cost model's layout.
+ *
+ * The workspace belongs to the search until it's finished.
+ */
+template<class Frontier, class Cost, class Goal>
+class Search
+{
+private:
+    using Layout = typename Cost::Layout;
+    static constexpr bool NEEDS_RC = Cost::NEEDS_RC || Layout::NEEDS_RC;
+
+    // small layouts are copied, so the loop can keep them in registers
+    using LocalLayout = conditional_t<is_trivially_copyable<Layout>::value, const Layout, const Layout&>;
+
+    const Cost _cost;
+    SolverWorkspace& _ws;
+    Frontier _frontier;
+    Goal _goal;
+    int _src;
+    SearchStatus _status;
+    size_t _popped;
+    RunStats* _stats;
+
+    // the workspace has to be sized before the frontier takes its arrays
+    static SolverWorkspace& begin(SolverWorkspace& ws, const Cost& cost)
+    {
+        ws.begin(cost.layout().size());
+        return ws;
+    }
+
+public:
+    /**
+     * start a search from src, nothing is expanded until step()
+     */
+    Search(const Cost& cost, SolverWorkspace& ws, int src, Goal goal, RunStats* stats = nullptr)
+        : _cost(cost), _ws(ws), _frontier(begin(ws, cost)), _goal(goal), _src(src),
+          _status(SearchStatus::RUNNING), _popped(0), _stats(stats)
+    {
+        ws.visit(src);
+        ws.parent(src) = FAIL;
+        if constexpr(Frontier::REOPEN)
+        {
+            ws.dist(src) = 0;
+        }
+        _frontier.push(src, 0);
+        STAT(stats, push(_frontier.size()));
+    }
+
+    /**
+     * take up to budget rooms off the frontier
+     */
+    SearchStatus step(size_t budget)
+    {
+        if(_status != SearchStatus::RUNNING)
+        {
+            return _status;
+        }
+
+        // locals, so the loop doesn't go back through this
+        const Cost cost = _cost;
+        SolverWorkspace& ws = _ws;
+        Frontier& frontier = _frontier;
+        RunStats* stats = _stats;
+        LocalLayout L = cost.layout();
+
+        size_t n = 0;
+        for(; n < budget && !frontier.empty(); n++)
+        {
+            int i = frontier.pop();
+            STAT(stats, pops++);
+            uint32_t d = 0;
+            if constexpr(Frontier::REOPEN)
+            {
+                d = frontier.cost();
+                if(ws.dist(i) != d)
+                {
+                    continue;
+                }
+            }
+            STAT(stats, expanded++);
+            if(_goal(i))
+            {
+                ws.trace_path(_src, i, L);
+                _popped += n+1;
+                _status = SearchStatus::FOUND;
+                return _status;
+            }
+
+            int r = 0;
+            int c = 0;
+            if constexpr(NEEDS_RC)
+            {
+                r = L.row(i);
+                c = L.column(i);
+            }
+            for_each_dir([&](auto dir)
+            {
+                constexpr int DIR = decltype(dir)::value;
+                uint8_t w = cost.template weight<DIR>(i, r, c);
+                if(w == EDGE_WALL)
+                {
+                    return;
+                }
+                int j = L.template neighbor<DIR>(i, r, c);
+                bool better = !ws.visited(j);
+                if constexpr(Frontier::REOPEN)
+                {
+                    better = better || d + w < ws.dist(j);
+                }
+                if(better)
+                {
+                    ws.visit(j);
+                    ws.parent(j) = DIR_OPPOSITE[DIR];
+                    if constexpr(Frontier::REOPEN)
+                    {
+                        ws.dist(j) = d + w;
+                    }
+                    frontier.push(j, d + w);
+                    STAT(stats, push(frontier.size()));
+                }
+            });
+        }
+        _popped += n;
+
+        if(frontier.empty())
+        {
+            _status = SearchStatus::EXHAUSTED;
+        }
+        return _status;
+    }
+
+    SearchStatus status() const { return _status; }
+
+    /**
+     * @return the number of rooms taken off the frontier so far
+     */
+    size_t popped() const { return _popped; }
+
+    /**
+     * The best answer so far: leave the path to the room seen so far
+     * that's closest to target (by manhattan distance) in the workspace.
+     * The search can carry on afterwards.
+     *
+     * @return the room the path goes to
+     */
+    int partial_path(int target)
+    {
+        const Layout& L = _cost.layout();
+        int tr = L.row(target);
+        int tc = L.column(target);
+
+        int best = _src;
+        int best_dist = abs(L.row(_src) - tr) + abs(L.column(_src) - tc);
+        for(size_t i = 0; i < L.size() && best_dist > 0; i++)
+        {
+            // padding in the layout is never visited
+            if(_ws.visited(i))
+            {
+                int d = abs(L.row(i) - tr) + abs(L.column(i) - tc);
+                if(d < best_dist)
+                {
+                    best = i;
+                    best_dist = d;
+                }
+            }
+        }
+        _ws.trace_path(_src, best, L);
+        return best;
+    }
+};
+
+/**
+ * Search from src until the goal test passes (or everything has been seen).
+ * If a goal is found, its path is left in the workspace.
+ * Rooms are numbered by their index in the cost model's layout.
+ *
+ * @return if a goal was reached
+ */
+template<class Frontier, class Cost, class Goal>
+bool search_kernel(const Cost& cost, SolverWorkspace& ws, int src, Goal goal, RunStats* stats = nullptr)
+{
+    Search<Frontier, Cost, Goal> search(cost, ws, src, goal, stats);
+    return search.step(SIZE_MAX) == SearchStatus::FOUND;
+}
+
+#endif // KERNEL_H
@@ -0,0 +1,182 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include "path.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Cell layouts for the Maze.
+ * A layout maps room (r,c) to an index in a flat array.
+ * Every layout has:
+ *   size()      the number of entries the array needs (including any padding)
+ *   index(r,c)  where room (r,c) lives
+ *   row(i), column(i)
+ *               the room that lives at index i
+ *   neighbor<DIR>(i, r, c)
+ *               where the room next to room i (at r,c) in direction DIR lives,
+ *               the neighbor has to be in the maze
+ *   NEEDS_RC    if neighbor needs r and c, or can work from i alone
+ *   name()      for printing benchmarks
+ *
+ * Searches number rooms by their index, so their own arrays
+ * are laid out the same way as the maze.
+ */
+
+/**
+ * Rooms stored one row after another.
+ * Moving up or down jumps a whole row.
+ */
+class RowMajorLayout
+{
+private:
+    int _cols;
+    size_t _size;
+
+public:
+    RowMajorLayout(int rows, int cols) : _cols(cols), _size(size_t(rows) * cols) {}
+
+    static constexpr bool NEEDS_RC = false;
+
+    size_t size() const              { return _size; }
+    size_t index(int r, int c) const { return size_t(r) * _cols + c; }
+    // searches number rooms with ints, and a 32 bit divide is a lot faster than 64
+    int row(size_t i) const          { return int(i) / _cols; }
+    int column(size_t i) const       { return int(i) % _cols; }
+    static const char* name()        { return "row-major"; }
+
+    template<int DIR>
+    size_t neighbor(size_t i, int, int) const { return i + DIR_DR[DIR]*_cols + DIR_DC[DIR]; }
+};
+
+/**
+ * Rooms stored in B x B blocks, blocks in row major order.
+ * Moving up or down usually stays in the same block.
+ * B must be a power of 2.
+ */
+template<int B>
+class TiledLayout
+{
+private:
+    static_assert((B & (B-1)) == 0, "tile size must be a power of 2");
+    static constexpr int SHIFT = __builtin_ctz(B);
+
+    size_t _across;
+    size_t _size;
+
+public:
+    TiledLayout(int rows, int cols)
+        : _across((cols + B-1) / B),
+          _size(size_t((rows + B-1) / B) * _across * B * B) {}
+
+    static constexpr bool NEEDS_RC = true;
+
+    size_t size() const { return _size; }
+    size_t index(int r, int c) const
+    {
+        size_t block = (r >> SHIFT) * _across + (c >> SHIFT);
+        return (block << (2*SHIFT)) | ((r & (B-1)) << SHIFT) | (c & (B-1));
+    }
+    int row(size_t i) const    { return (i >> (2*SHIFT)) / _across << SHIFT | (i >> SHIFT & (B-1)); }
+    int column(size_t i) const { return (i >> (2*SHIFT)) % _across << SHIFT | (i & (B-1)); }
+    static const char* name() { return B == 8 ? "tiled-8x8" : B == 16 ? "tiled-16x16" : "tiled"; }
+
+    template<int DIR>
+    size_t neighbor(size_t, int r, int c) const { return index(r + DIR_DR[DIR], c + DIR_DC[DIR]); }
+};
+
+/**
+ * Rooms stored in Morton (Z-order), the bits of r and c are interleaved.
+ * If one side needs more bits than the other, the extra bits go on top,
+ * so a long skinny maze is a row of Z-order squares.
+ *
+ * The interleaved bits for every row and every column are precomputed,
+ * so index is two loads and an or.
+ */
+class MortonLayout
+{
+private:
+    vector<size_t> _rpart;
+    vector<size_t> _cpart;
+    size_t _size;
+    int _shared;        // bits interleaved
+    bool _rows_on_top;  // the extra bits above them are the row's
+
+    // the inverse of spread: every other bit, starting at bit 0, packed together
+    static size_t compact(uint64_t x)
+    {
+        x &= 0x5555555555555555ULL;
+        x = (x | x >> 1)  & 0x3333333333333333ULL;
+        x = (x | x >> 2)  & 0x0F0F0F0F0F0F0F0FULL;
+        x = (x | x >> 4)  & 0x00FF00FF00FF00FFULL;
+        x = (x | x >> 8)  & 0x0000FFFF0000FFFFULL;
+        x = (x | x >> 16) & 0x00000000FFFFFFFFULL;
+        return x;
+    }
+
+    // the bits of one side, first is 1 for the row and 0 for the column
+    size_t unspread(size_t i, int first, bool on_top) const
+    {
+        size_t low = i & ((size_t(1) << 2*_shared) - 1);
+        size_t x = compact(low >> first);
+        return on_top ? x | (i >> 2*_shared) << _shared : x;
+    }
+
+    static int bits(int n)
+    {
+        int b = 0;
+        while((1 << b) < n)
+        {
+            b++;
+        }
+        return b;
+    }
+
+    // spread the bits of x out, starting at bit first and skipping every other bit
+    // until we run out of bits on the other side.
+    static size_t spread(size_t x, int first, int shared)
+    {
+        size_t out = 0;
+        for(int i = 0; x >> i; i++)
+        {
+            int pos = i < shared ? 2*i + first : shared + i;
+            out |= ((x >> i) & 1) << pos;
+        }
+        return out;
+    }
+
+public:
+    MortonLayout(int rows, int cols) : _rpart(rows), _cpart(cols)
+    {
+        int rb = bits(rows);
+        int cb = bits(cols);
+        int shared = rb < cb ? rb : cb;
+        _shared = shared;
+        _rows_on_top = rb > cb;
+        for(int r = 0; r < rows; r++)
+        {
+            _rpart[r] = spread(r, 1, shared);
+        }
+        for(int c = 0; c < cols; c++)
+        {
+            _cpart[c] = spread(c, 0, shared);
+        }
+        _size = size_t(1) << (rb + cb);
+    }
+
+    static constexpr bool NEEDS_RC = true;
+
+    size_t size() const              { return _size; }
+    size_t index(int r, int c) const { return _rpart[r] | _cpart[c]; }
+    int row(size_t i) const          { return unspread(i, 1, _rows_on_top); }
+    int column(size_t i) const       { return unspread(i, 0, !_rows_on_top); }
+    static const char* name()        { return "morton"; }
+
+    template<int DIR>
+    size_t neighbor(size_t, int r, int c) const { return _rpart[r + DIR_DR[DIR]] | _cpart[c + DIR_DC[DIR]]; }
+};
+
+#endif // LAYOUT_H
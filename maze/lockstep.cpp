@@ -0,0 +1,160 @@
+#include "lockstep.h"
+#include <algorithm>
+
+using namespace std;
+
+// rooms per block in a level, a whole SSE register of lane words
+const size_t BLOCK = 8;
+
+LockstepBatch::LockstepBatch(int rows, int cols)
+    : _rows(rows), _cols(cols), _cells(size_t(rows) * cols), _size(0), _src(0), _goal(0), _found(0)
+{
+    // the rooms past the last one, up to a whole block, are never reached
+    size_t planes = (_cells + BLOCK-1) / BLOCK * BLOCK + 2*cols;
+    _right.resize(planes);
+    _down.resize(planes);
+    _front.resize(planes);
+    _next.resize(planes);
+    _seen.resize(planes);
+    _parent_lo.resize(planes);
+    _parent_hi.resize(planes);
+}
+
+void LockstepBatch::clear()
+{
+    fill(_right.begin(), _right.end(), 0);
+    fill(_down.begin(), _down.end(), 0);
+    _size = 0;
+    _found = 0;
+}
+
+int LockstepBatch::add(const Maze& m)
+{
+    if(full() || m.rows() != _rows || m.columns() != _cols)
+    {
+        return -1;
+    }
+    int lane = _size++;
+    lanes_t bit = lanes_t(1u << lane);
+    lanes_t* right = _right.data() + _cols;
+    lanes_t* down = _down.data() + _cols;
+    for(int r = 0; r < _rows; r++)
+    {
+        for(int c = 0; c < _cols; c++)
+        {
+            size_t i = size_t(r)*_cols + c;
+            right[i] |= m.can_go_right(r, c) ? bit : 0;
+            down[i] |= m.can_go_down(r, c) ? bit : 0;
+        }
+    }
+    return lane;
+}
+
+/**
+ * One level for every lane: the rooms next to the frontier, through an open wall,
+ * that haven't been seen yet.
+ * A room reached from more than one side takes the first of up, left, down, right
+ * as its parent, and the parent's direction is split into its low and high bits.
+ *
+ * The rooms go in blocks of BLOCK with nothing but ands and ors in between,
+ * so each block turns into a few vector instructions even at -O2
+ * (the planes never overlap, and saying so saves the compiler from checking).
+ *
+ * @param blocks number of blocks, the planes are padded out to a whole block
+ * @return the lanes that reached anything
+ */
+static uint16_t bfs_level(const uint16_t* __restrict right, const uint16_t* __restrict down,
+                          const uint16_t* __restrict front, uint16_t* __restrict next,
+                          uint16_t* __restrict seen, uint16_t* __restrict parent_lo,
+                          uint16_t* __restrict parent_hi, size_t blocks, int cols)
+{
+    uint16_t any[BLOCK] = {};
+    for(size_t b = 0; b < blocks*BLOCK; b += BLOCK)
+    {
+        for(size_t k = 0; k < BLOCK; k++)
+        {
+            size_t i = b + k;
+            uint16_t from_up = front[i - cols] & down[i - cols];
+            uint16_t from_left = front[i - 1] & right[i - 1];
+            uint16_t from_down = front[i + cols] & down[i];
+            uint16_t from_right = front[i + 1] & right[i];
+            uint16_t reached = (from_up | from_left | from_down | from_right) & ~seen[i];
+
+            // UP is 0, LEFT 1, DOWN 2 and RIGHT 3
+            uint16_t left = from_left & ~from_up;
+            uint16_t down_only = from_down & ~from_up & ~from_left;
+            uint16_t right_only = ~(from_up | from_left | from_down);
+            parent_lo[i] |= (left | right_only) & reached;
+            parent_hi[i] |= (down_only | right_only) & reached;
+
+            next[i] = reached;
+            seen[i] |= reached;
+            any[k] |= reached;
+        }
+    }
+
+    uint16_t reached = 0;
+    for(size_t k = 0; k < BLOCK; k++)
+    {
+        reached |= any[k];
+    }
+    return reached;
+}
+
+int LockstepBatch::solve_bfs(int src, int goal)
+{
+    _src = src;
+    _goal = goal;
+    _found = 0;
+    if(_size == 0)
+    {
+        return 0;
+    }
+
+    fill(_front.begin(), _front.end(), 0);
+    fill(_seen.begin(), _seen.end(), 0);
+    fill(_parent_lo.begin(), _parent_lo.end(), 0);
+    fill(_parent_hi.begin(), _parent_hi.end(), 0);
+
+    const lanes_t lanes = all();
+    lanes_t* front = _front.data() + _cols;
+    lanes_t* next = _next.data() + _cols;
+    lanes_t* seen = _seen.data() + _cols;
+    front[src] = lanes;
+    seen[src] = lanes;
+
+    while((seen[goal] & lanes) != lanes)
+    {
+        lanes_t any = bfs_level(_right.data() + _cols, _down.data() + _cols, front, next, seen,
+                                _parent_lo.data() + _cols, _parent_hi.data() + _cols,
+                                (_cells + BLOCK-1) / BLOCK, _cols);
+        if(!any)
+        {
+            break;
+        }
+        swap(front, next);
+    }
+
+    _found = seen[goal] & lanes;
+    return __builtin_popcount(_found);
+}
+
+path LockstepBatch::solution(int lane) const
+{
+    path p;
+    if(!solved(lane))
+    {
+        return p;
+    }
+    const lanes_t* lo = _parent_lo.data() + _cols;
+    const lanes_t* hi = _parent_hi.data() + _cols;
+    int i = _goal;
+    while(i != _src)
+    {
+        p.push_front(make_pair(i / _cols, i % _cols));
+        int dir = ((hi[i] >> lane) & 1) << 1 | ((lo[i] >> lane) & 1);
+        i += DIR_DR[dir]*_cols + DIR_DC[dir];
+    }
+    p.push_front(make_pair(i / _cols, i % _cols));
+    return p;
+}
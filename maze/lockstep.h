@@ -0,0 +1,100 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include "maze.h"
+#include "path.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Up to 16 mazes of the same size, solved together with one breadth first search.
+ *
+ * Every plane holds one 16 bit word per room, and bit l of the word is lane l's maze,
+ * so the walls of all the mazes are interleaved room by room.
+ * A level of the search is a pass over the planes with nothing but ands and ors,
+ * which the compiler vectorizes across rooms, so each instruction moves
+ * the frontier of every maze through several rooms at once.
+ * This pays off for small mazes, where a search per maze is mostly overhead.
+ *
+ * Every lane takes as many levels as the longest path in the batch.
+ * The planes are sized once, so a batch can be cleared and refilled
+ * without touching the heap.
+ */
+class LockstepBatch
+{
+public:
+    static constexpr int LANES = 16;
+
+private:
+    using lanes_t = uint16_t;
+
+    int _rows;
+    int _cols;
+    size_t _cells;
+    int _size;
+    int _src;
+    int _goal;
+    lanes_t _found;
+
+    // each plane has a row of padding on both sides,
+    // so the neighbors of every room can be read without checking the bounds.
+    // Room i is at i + _cols.
+    vector<lanes_t> _right;     // can go right from the room
+    vector<lanes_t> _down;      // can go down from the room
+    vector<lanes_t> _front;     // reached on the last level
+    vector<lanes_t> _next;      // reached on this level
+    vector<lanes_t> _seen;
+    // the direction back to the parent, two bits split over two planes
+    vector<lanes_t> _parent_lo;
+    vector<lanes_t> _parent_hi;
+
+    // a bit for every lane with a maze in it
+    lanes_t all() const { return lanes_t((1u << _size) - 1); }
+
+public:
+    LockstepBatch(int rows, int cols);
+
+    int rows() const    { return _rows; }
+    int columns() const { return _cols; }
+
+    /**
+     * @return the number of mazes in the batch
+     */
+    int size() const  { return _size; }
+    bool full() const { return _size == LANES; }
+
+    /**
+     * take every maze out of the batch
+     */
+    void clear();
+
+    /**
+     * copy m's walls into the next lane
+     *
+     * @return the lane, or -1 if the batch is full or m is the wrong size
+     */
+    int add(const Maze& m);
+
+    /**
+     * Breadth first search from src to goal in every lane at once
+     * (rooms numbered r*cols + c).
+     *
+     * @return the number of lanes that reached goal
+     */
+    int solve_bfs(int src, int goal);
+
+    /**
+     * @return if lane reached the goal in the last solve
+     */
+    bool solved(int lane) const { return (_found >> lane) & 1; }
+
+    /**
+     * @return lane's shortest path from the last solve, from src to goal,
+     *         or an empty path if it didn't reach the goal
+     */
+    path solution(int lane) const;
+};
+
+#endif // LOCKSTEP_H
@@ -1,5 +1,7 @@
 #include "maze.h"
+#include "validate.h"
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <vector>
 #include <random>
@@ -22,45 +24,82 @@ const char* ue = "\033[0m";
  * @rows number of rows
  * @cols number of columns
  */
-Maze::Maze(int rows, int cols) : _rows(rows), _cols(cols),
-                                 _squares(rows, vector<Square>(cols, Square()))
+template<class Layout>
+BasicMaze<Layout>::BasicMaze(int rows, int cols) : BasicMaze(rows, cols, random_device()())
 {
-    gen_random_maze();
 }
 
 /**
- * Generates a random maze using a depth first search.
+ * Constructor for a maze generated from a fixed seed
+ *
+ * @rows number of rows
+ * @cols number of columns
+ * @seed seed for the random number generator
+ * @stats counters for the generator, may be null
  */
-void Maze::gen_random_maze()
+template<class Layout>
+BasicMaze<Layout>::BasicMaze(int rows, int cols, unsigned seed, RunStats* stats)
+    : BasicMaze(rows, cols, seed, MazeParams(), stats)
 {
-    //make a vector of cells we've already seen
-    //so we don't get in an infinite loop
-    vector<vector<bool>> seen(_rows, vector<bool>(_cols, false));
+}
 
+template<class Layout>
+BasicMaze<Layout>::BasicMaze(int rows, int cols, unsigned seed, const MazeParams& params, RunStats* stats)
+    : _rows(rows), _cols(cols), _layout(rows, cols), _squares(_layout.size(), Square())
+{
+    gen_random_maze(seed, params, stats);
+}
+
+/**
+ * Generates a random maze using a depth first search.
+ */
+template<class Layout>
+void BasicMaze<Layout>::gen_random_maze(unsigned seed, const MazeParams& params, RunStats* stats)
+{
     // Initialize random
     // We don't need good randomness, we just need it to be different
     // every time we run the program
-    random_device r;
-    default_random_engine rng(r());
-    gen_dfs(seen, 0, 0, rng);
-
-    // delete about 1/10 of the walls
-    delete_walls(0.1, r);
-
-    set_heights();
+    default_random_engine rng(seed);
+    STAT(stats, begin_phase("dfs"));
+    gen_dfs(rng, stats);
+    STAT(stats, end_phase());
+
+    STAT(stats, begin_phase("delete walls"));
+    delete_walls(params.delete_frac, rng);
+    STAT(stats, end_phase());
+
+    STAT(stats, begin_phase("heights"));
+    set_heights(params, rng);
+    STAT(stats, end_phase());
 }
 
 
 /**
  * Sets all squares to a random height
  */
-void Maze::set_heights()
+template<class Layout>
+void BasicMaze<Layout>::set_heights(const MazeParams& params, default_random_engine& rng)
 {
+    int lo = max(0, params.min_height);
+    int hi = min(max(lo, params.max_height), lo + 254);
+
+    uniform_int_distribution<int> uniform(lo, hi);
+    // a flat range still needs a spread above 0, the draw is clamped to lo anyway
+    normal_distribution<double> normal((lo + hi) / 2.0, max(1, hi - lo) / 6.0);
+    exponential_distribution<double> exponential(4.0 / max(1, hi - lo));
+
     for(int r = 0; r < _rows; r++)
     {
         for(int c = 0; c < _cols; c++)
         {
-            _squares[r][c].set_height(rand()%10);
+            int h = lo;
+            switch(params.height_dist)
+            {
+                case HeightDist::UNIFORM:     h = uniform(rng); break;
+                case HeightDist::NORMAL:      h = lround(normal(rng)); break;
+                case HeightDist::EXPONENTIAL: h = lo + lround(exponential(rng)); break;
+            }
+            at(r,c).set_height(min(hi, max(lo, h)));
         }
     }
 }
@@ -68,17 +107,58 @@ void Maze::set_heights()
 /**
  * delete some of the walls
  *
- * @param frac the fraction of walls to delete
+ * @param frac the fraction of walls to delete, as a fraction of the rooms
  * @param r our random number generator.
  */
-void Maze::delete_walls(double frac, random_device& rng)
+template<class Layout>
+void BasicMaze<Layout>::delete_walls(double frac, default_random_engine& rng)
 {
+    // the dfs opened rows*cols-1 of the inside walls,
+    // so that's how many are left to delete
+    long long rooms = (long long)_rows * _cols;
+    long long inside = (long long)(_rows-1) * _cols + (long long)_rows * (_cols-1);
+    long long closed = max(0LL, inside - (rooms-1));
+    long long count = min(closed, (long long)ceil(max(0.0, rooms * frac)));
+    if(count == 0)
+    {
+        return;
+    }
+
+    if(count > closed / 2)
+    {
+        // picking at random would mostly find walls that are already gone,
+        // so list the walls that are left and pick from those
+        vector<pair<int,int>> walls;    // room number and direction
+        for(int r = 0; r < _rows; r++)
+        {
+            for(int c = 0; c < _cols; c++)
+            {
+                if(c+1 < _cols && !at(r,c).can_go_dir(RIGHT))
+                {
+                    walls.push_back(make_pair(r*_cols + c, RIGHT));
+                }
+                if(r+1 < _rows && !at(r,c).can_go_dir(DOWN))
+                {
+                    walls.push_back(make_pair(r*_cols + c, DOWN));
+                }
+            }
+        }
+        for(long long i = 0; i < count; i++)
+        {
+            uniform_int_distribution<long long> pick(i, walls.size()-1);
+            swap(walls[i], walls[pick(rng)]);
+            auto [room, dir] = walls[i];
+            set_wall(room / _cols, room % _cols, dir, true);
+        }
+        return;
+    }
+
     // set up uniform distributions for deleting walls
-    uniform_int_distribution<int> ur(1, _rows-2);
-    uniform_int_distribution<int> uc(1, _cols-2);
+    uniform_int_distribution<int> ur(0, _rows-1);
+    uniform_int_distribution<int> uc(0, _cols-1);
     uniform_int_distribution<int> u(0, 3);
 
-    for(int i = 0; i < _rows*_cols*frac; i++)
+    for(long long i = 0; i < count; i++)
     {
         //keep going until we actually delete something
         bool deleted = false;
@@ -89,12 +169,8 @@ void Maze::delete_walls(double frac, random_device& rng)
             int dir = u(rng);
 
             // did we actually delete anything?
-            deleted = !_squares[r][c].can_go_dir(dir);
-
-            auto [dr,dc] = moveIn(dir);
-
-            _squares[r][c].set_dir(true, dir);
-            _squares[r+dr][c+dc].set_dir(true, opposite(dir));
+            // (walls on the outside of the maze stay up)
+            deleted = !at(r,c).can_go_dir(dir) && set_wall(r, c, dir, true);
         }
     }
 }
@@ -103,56 +179,120 @@ void Maze::delete_walls(double frac, random_device& rng)
 /**
  *
  * Generates a random maze using a depth first search.
- * This version runs recursively.
+ * This version keeps its own stack instead of recursing,
+ * so big mazes don't run out of stack space.
  *
- * @param seen vector of squares we've already visited
- * @param r the current row that we're on
- * @param c the current column that we're on
+ * @param rng the random number generator
+ * @param stats counters for the generator, may be null
  *
  */
-void Maze::gen_dfs(vector<vector<bool> >& seen, int r, int c, default_random_engine& rng)
+template<class Layout>
+void BasicMaze<Layout>::gen_dfs(default_random_engine& rng, RunStats* stats)
 {
-    seen[r][c] = true;
+    //make a vector of cells we've already seen
+    //so we don't get in an infinite loop
+    vector<bool> seen(_layout.size(), false);
 
-    //shuffel the directions, so we actually go in a random direction
-    vector<int> order = {UP,LEFT,DOWN,RIGHT};
-    shuffle(order.begin(), order.end(), rng);
+    // a room on the stack, the random order we try the directions in,
+    // and how many of them we've tried
+    struct Frame
+    {
+        int r, c;
+        int order[4];
+        int next;
+    };
+    vector<Frame> stack;
 
-    // for each possible direction check if we can go there
-    // we use order to randomly permute the directions.
-    for(int i = 0; i < 4; i++)
+    auto visit = [&](int r, int c)
     {
-        auto [dr,dc] = moveIn(order[i]);
+        seen[_layout.index(r,c)] = true;
 
+        //shuffel the directions, so we actually go in a random direction
+        Frame f = {r, c, {UP,LEFT,DOWN,RIGHT}, 0};
+        shuffle(f.order, f.order+4, rng);
+        stack.push_back(f);
+        STAT(stats, push(stack.size()));
+    };
+
+    visit(0, 0);
+    while(!stack.empty())
+    {
+        Frame& f = stack.back();
+        if(f.next == 4)
+        {
+            stack.pop_back();
+            STAT(stats, pops++);
+            STAT(stats, expanded++);
+            continue;
+        }
+
+        // try the next direction
+        // we use order to randomly permute the directions.
+        int dir = f.order[f.next++];
+        int r = f.r;
+        int c = f.c;
+        auto [dr,dc] = moveIn(dir);
 
         //if we are within the bounds of our maze
-        //AND we haven't visited the square above us yet.
+        //AND we haven't visited the square in that direction yet.
         if(r+dr >= 0 && r+dr < _rows &&
            c+dc >= 0 && c+dc < _cols &&
-           !seen[r+dr][c+dc])
+           !seen[_layout.index(r+dr,c+dc)])
         {
-            //kill the wall between this square and the square above us
-            _squares[r][c].set_dir(true, order[i]);
-            _squares[r+dr][c+dc].set_dir(true, opposite(order[i]));
+            //kill the wall between this square and the next one
+            at(r,c).set_dir(true, dir);
+            at(r+dr,c+dc).set_dir(true, opposite(dir));
 
-            //continue from the square above us.
-            gen_dfs(seen, r+dr, c+dc, rng);
+            //continue from the next square.
+            visit(r+dr, c+dc);
         }
     }
 }
 
+/**
+ * open or close a wall, on both sides
+ */
+template<class Layout>
+bool BasicMaze<Layout>::set_wall(int r, int c, int dir, bool open)
+{
+    auto [dr,dc] = moveIn(dir);
+    if(r < 0 || r >= _rows || c < 0 || c >= _cols ||
+       r+dr < 0 || r+dr >= _rows || c+dc < 0 || c+dc >= _cols)
+    {
+        return false;
+    }
+    at(r,c).set_dir(open, dir);
+    at(r+dr,c+dc).set_dir(open, opposite(dir));
+    return true;
+}
+
+
 ////////////////////////////////////////////////////////////////////////
 //
 // print the maze
 //
 ////////////////////////////////////////////////////////////////////////
 
+/**
+ * Every room is one character wide, so heights 0-9 print as digits,
+ * 10-35 as the letters a-z, and anything higher as +
+ */
+static char height_char(int height)
+{
+    if(height < 10)
+        return '0' + height;
+    if(height < 36)
+        return 'a' + (height - 10);
+    return '+';
+}
+
 /**
  * Print out the maze
  *
- * @param weighted print out the heights of the rooms
+ * @param weighted print out the heights of the rooms (see height_char)
  */
-void Maze::print_maze(ostream& out, bool weighted) const
+template<class Layout>
+void BasicMaze<Layout>::print_maze(ostream& out, bool weighted) const
 {
     //print the top boarder of the maze
     out << us;
@@ -173,21 +313,21 @@ void Maze::print_maze(ostream& out, bool weighted) const
         //last square in a row/column, can never leave the maze
         for(int c = 0; c < _cols; c++)
         {
-            if(_squares[r][c].can_go_dir(DOWN))
+            if(at(r,c).can_go_dir(DOWN))
             {
                 if(weighted)
-                    out << _squares[r][c].height();
+                    out << height_char(at(r,c).height());
                 else
                     out << " ";
             }
             else
             {
                 if(weighted)
-                    out << us << _squares[r][c].height() << ue;
+                    out << us << height_char(at(r,c).height()) << ue;
                 else
                     out << us << " " << ue;
             }
-            if(_squares[r][c].can_go_dir(RIGHT))
+            if(at(r,c).can_go_dir(RIGHT))
                 out << us << " " << ue;
             else
                 out << '|';
@@ -204,30 +344,26 @@ void Maze::print_maze(ostream& out, bool weighted) const
  * @param weighted print out the heights
  * @param tour are we checking the path or the tour
  */
-void Maze::print_maze_with_path(ostream& out, const list<point>& path, bool weighted, bool tour) const
+template<class Layout>
+void BasicMaze<Layout>::print_maze_with_path(ostream& out, const list<point>& path, bool weighted, bool tour) const
 {
-
-    //keep track of what spaces are on the board
-    vector<vector<bool>> board(_rows, vector<bool>(_cols, false));
-    vector<int> heights;
-
-    int weight = 0;
-
-    // get all of the heights in the path
-    if(!path.empty())
+    // mark the rooms on the path, and check it in the same pass
+    vector<bool> on_path(size_t(_rows)*_cols, false);
+    vector<point> waypoints;
+    if(tour)
     {
-        for(auto [r,c] : path)
-        {
-            board[r][c] = true;
-            heights.push_back(_squares[r][c].height());
-        }
-
-        // get the total cost of the path
-        for(int i = 0; i < heights.size()-1; i++)
+        waypoints = corner_waypoints(_rows, _cols);
+    }
+    BasicPathValidator<Layout> validator(*this, waypoints);
+    for(auto [r,c] : path)
+    {
+        validator.step(make_pair(r,c));
+        if(r >= 0 && r < _rows && c >= 0 && c < _cols)
         {
-            weight += abs(heights[i] - heights[i+1]);
+            on_path[size_t(r)*_cols + c] = true;
         }
     }
+    const PathCheck& check = validator.result();
 
     //print the top boarder of the maze
     out << us;
@@ -249,9 +385,9 @@ void Maze::print_maze_with_path(ostream& out, const list<point>& path, bool weig
         for(int c = 0; c < _cols; c++)
         {
             // if this square is in the path, print a *
-            if(board[r][c])
+            if(on_path[size_t(r)*_cols + c])
             {
-                if(_squares[r][c].can_go_dir(DOWN))
+                if(at(r,c).can_go_dir(DOWN))
                     out << "*";
                 else 
                     out << us << "*" << ue;
@@ -259,8 +395,8 @@ void Maze::print_maze_with_path(ostream& out, const list<point>& path, bool weig
             else
             {
                 // either print out the height or a space
-                char space = weighted ? _squares[r][c].height() + '0' : ' ';
-                if(_squares[r][c].can_go_dir(DOWN))
+                char space = weighted ? height_char(at(r,c).height()) : ' ';
+                if(at(r,c).can_go_dir(DOWN))
                 {
                     out << space;
                 }
@@ -269,7 +405,7 @@ void Maze::print_maze_with_path(ostream& out, const list<point>& path, bool weig
                     out << us << space << ue;
                 }
             }
-            if(_squares[r][c].can_go_dir(RIGHT))
+            if(at(r,c).can_go_dir(RIGHT))
                 out << us << " " << ue;
             else
                 out << '|';
@@ -277,16 +413,21 @@ void Maze::print_maze_with_path(ostream& out, const list<point>& path, bool weig
         out << endl;
     }
 
-    out << "total time: " << weight << endl;
+    out << "total time: " << check.cost << endl;
 
-    // check to see if it's a valid path
-    if((!tour  && valid_solution(*this,path)) ||
-       (tour && valid_tour(*this,path)))
+    bool valid = tour ? is_tour(check, waypoints[0]) : is_solution(check, _rows, _cols);
+    if(valid)
         out << "valid" << endl;
     else
         out << "invalid" << endl;
 }
 
+// the layouts we build mazes with
+template class BasicMaze<RowMajorLayout>;
+template class BasicMaze<TiledLayout<8>>;
+template class BasicMaze<TiledLayout<16>>;
+template class BasicMaze<MortonLayout>;
+
 
 /**
  * Check to see if it's a valid path through the maze.
@@ -297,10 +438,7 @@ void Maze::print_maze_with_path(ostream& out, const list<point>& path, bool weig
  */
 bool valid_solution(const Maze& m, const list<point>& p)
 {
-    return !p.empty() &&
-           p.front() == make_pair(0,0) &&
-           p.back() == make_pair(m.rows()-1, m.columns()-1) &&
-           valid_path(m, p);
+    return is_solution(check_path(m, p), m.rows(), m.columns());
 }
 
 /**
@@ -312,50 +450,32 @@ bool valid_solution(const Maze& m, const list<point>& p)
  */
 bool valid_tour(const Maze& m, const list<point>& p)
 {
-    // if our path contains (0,0) (0,columns-1) (rows-1,0) (rows-1,columns-1)
-    // and we start and end on rows/2 and columns/2
-    // and it's a valid path
-    return !p.empty() &&
-           find(p.begin(), p.end(), make_pair(0, 0)) != p.end() &&
-           find(p.begin(), p.end(), make_pair(0, m.columns()-1)) != p.end() &&
-           find(p.begin(), p.end(), make_pair(m.rows()-1, 0)) != p.end() &&
-           find(p.begin(), p.end(), make_pair(m.rows()-1, m.columns()-1)) != p.end() &&
-           p.front() == make_pair(m.rows()/2,m.columns()/2) &&
-           p.back() == make_pair(m.rows()/2,m.columns()/2) &&
-           valid_path(m, p);
+    vector<point> waypoints = corner_waypoints(m.rows(), m.columns());
+    return is_tour(check_path(m, p, waypoints), waypoints[0]);
 }
 
+/**
+ * Check to see if it's a valid tour through a set of waypoints.
+ *
+ * if we start and end on waypoints[0]
+ * and our path contains every waypoint
+ * and it's a valid path
+ */
+bool valid_waypoint_tour(const Maze& m, const list<point>& p, const vector<point>& waypoints)
+{
+    return !waypoints.empty() && is_tour(check_path(m, p, waypoints), waypoints[0]);
+}
 
 /**
  * Check to see if its a valid path.
  *
  * A path is valid if
  * its not empty,
- * and every node is adjacent to the previous one,
+ * and every room is in the maze and adjacent to the previous one,
  * and we can travel between each room.
  */
 bool valid_path(const Maze& m, const list<point>& p)
 {
-    if(p.empty())
-    {
-        return 0;
-    }
-
-    auto it = p.begin();
-    point last = *it;
-
-    // start at the second room
-    it++;
-
-    for(; it != p.end(); it++)
-    {
-        // can we move in this direction
-        int dir = direction(*it, last);
-        if(dir == FAIL || !m.can_go(dir, it->first, it->second))
-        {
-            return false;
-        }
-        last = *it;
-    }
-    return true;
+    PathCheck check = check_path(m, p);
+    return check.valid && check.rooms > 0;
 }
@@ -3,20 +3,61 @@
 
 #include "square.h"
 #include "path.h"
+#include "layout.h"
+#include "stats.h"
 #include <vector>
 #include <iostream>
 #include<random>
 
-class Maze
+// how room heights are spread between the lowest and highest height
+enum class HeightDist
+{
+    UNIFORM,        // every height equally likely
+    NORMAL,         // bunched around the middle
+    EXPONENTIAL     // mostly low, with a few peaks
+};
+
+/**
+ * How a random maze is generated.
+ * The defaults are the original generator.
+ */
+struct MazeParams
+{
+    // walls knocked down after the dfs, as a fraction of the rooms.
+    // 0 is a perfect maze (one path between any two rooms),
+    // bigger values add more loops, up to every wall being gone.
+    double delete_frac = 0.1;
+
+    // heights run from min_height to max_height (min_height is at least 0).
+    // Edge costs are height differences and have to fit in a byte,
+    // so max_height is capped at min_height + 254. The heights themselves aren't capped.
+    int min_height = 0;
+    int max_height = 9;
+    HeightDist height_dist = HeightDist::UNIFORM;
+};
+
+/**
+ * A maze stored with a compile time cell layout (see layout.h).
+ * The layout only changes where rooms live in memory,
+ * every layout generates the same maze from the same seed.
+ *
+ * Maze uses the row major layout.
+ */
+template<class Layout>
+class BasicMaze
 {
 private:
-    vector<vector<Square>> _squares;
     int _rows;
     int _cols;
-    void gen_dfs(vector<vector<bool>>& seen, int r, int c, default_random_engine& rng);
-    void delete_walls(double frac, random_device& r);
-    void set_heights();
-    void gen_random_maze();
+    Layout _layout;
+    vector<Square> _squares;
+    void gen_dfs(default_random_engine& rng, RunStats* stats);
+    void delete_walls(double frac, default_random_engine& rng);
+    void set_heights(const MazeParams& params, default_random_engine& rng);
+    void gen_random_maze(unsigned seed, const MazeParams& params, RunStats* stats);
+
+    Square& at(int r, int c)             {return _squares[_layout.index(r,c)];}
+    const Square& at(int r, int c) const {return _squares[_layout.index(r,c)];}
 
 public:
 
@@ -29,11 +70,25 @@ public:
      * @rows number of rows
      * @cols number of columns
      */
-    Maze(int rows, int cols);
+    BasicMaze(int rows, int cols);
+
+    /**
+     * Same as above, but the maze is generated from seed,
+     * so the same seed always gives the same maze.
+     *
+     * @stats if not null, gets the generator's counters (MAZE_STATS builds only)
+     */
+    BasicMaze(int rows, int cols, unsigned seed, RunStats* stats = nullptr);
+
+    /**
+     * Same as above, with the generator's parameters.
+     */
+    BasicMaze(int rows, int cols, unsigned seed, const MazeParams& params, RunStats* stats = nullptr);
 
 
     /**
-     * print out the maze in a human readable format
+     * print out the maze in a human readable format.
+     * Weighted rooms show their height as one character: 0-9, then a-z, then + above 35.
      */
     void print_maze(ostream& out, bool weighted) const;
 
@@ -53,15 +108,33 @@ public:
      */
     int columns() const { return _cols;}
 
+    /**
+     * @return the cell layout, so solvers can lay out their own arrays the same way
+     */
+    const Layout& layout() const { return _layout; }
+
     /**
      * @return if you can go from room (r,c) in direction dir
      */
-    bool can_go(int dir, int r, int c) const {return _squares[r][c].can_go_dir(dir);}
+    bool can_go(int dir, int r, int c) const {return at(r,c).can_go_dir(dir);}
+
+    bool can_go_up(int r, int c) const       {return at(r,c).can_go_dir(UP);}
+    bool can_go_down(int r, int c) const     {return at(r,c).can_go_dir(DOWN);}
+    bool can_go_left(int r, int c) const     {return at(r,c).can_go_dir(LEFT);}
+    bool can_go_right(int r, int c) const    {return at(r,c).can_go_dir(RIGHT);}
+
+    /**
+     * open or close the wall between room (r,c) and its neighbor in direction dir.
+     * Anything built from the maze (edge costs, components) has to be rebuilt.
+     *
+     * @return false if the neighbor is outside the maze
+     */
+    bool set_wall(int r, int c, int dir, bool open);
 
-    bool can_go_up(int r, int c) const       {return _squares[r][c].can_go_dir(UP);}
-    bool can_go_down(int r, int c) const     {return _squares[r][c].can_go_dir(DOWN);}
-    bool can_go_left(int r, int c) const     {return _squares[r][c].can_go_dir(LEFT);}
-    bool can_go_right(int r, int c) const    {return _squares[r][c].can_go_dir(RIGHT);}
+    /**
+     * @return the height of room (r,c)
+     */
+    int height(int r, int c) const {return at(r,c).height();}
 
     /**
      * @return the cost of moving from room (r,c) in direction dir
@@ -69,10 +142,12 @@ public:
     int cost(int r, int c, int dir) const
     {
         auto [dr,dc] = moveIn(dir);
-        return abs(_squares[r][c].height() - _squares[r+dr][c+dc].height());
+        return abs(at(r,c).height() - at(r+dr,c+dc).height());
     }
 };
 
+using Maze = BasicMaze<RowMajorLayout>;
+
 /**
  * @return if p is a valid path from (0,0) to (r-1,c-1) in m
  */
@@ -83,6 +158,12 @@ bool valid_solution(const Maze& m, const path& p);
  */
 bool valid_tour(const Maze& m, const path& p);
 
+/**
+ * @return if p is a valid tour that starts and ends at waypoints[0]
+ *         and visits every waypoint in m
+ */
+bool valid_waypoint_tour(const Maze& m, const path& p, const vector<point>& waypoints);
+
 /**
  * @return if p is a valid path in m
  */
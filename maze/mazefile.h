@@ -0,0 +1,37 @@
+#ifndef MAZEFILE_H
+#define MAZEFILE_H
+
+#include <cstdint>
+
+/**
+ * On disk format for mazes that are too big to keep in memory.
+ *
+ * A file starts with a MazeFileHeader, followed by one byte per room.
+ * Row files (MAZE_ROWS_MAGIC) store the rooms row by row.
+ * Tiled files (MAZE_TILES_MAGIC) store tile x tile blocks of rooms,
+ * the blocks are in row major order, and so are the rooms in each block.
+ * The blocks on the right and bottom edges are padded out to a full tile.
+ *
+ * Each room only stores its right and down walls,
+ * the left and up walls are the right and down walls of its neighbors.
+ */
+
+const char MAZE_ROWS_MAGIC[8]  = {'M','A','Z','E','R','O','W','S'};
+const char MAZE_TILES_MAGIC[8] = {'M','A','Z','E','T','I','L','E'};
+
+struct MazeFileHeader
+{
+    char magic[8];
+    int64_t rows;
+    int64_t cols;
+    int64_t tile;   // 0 for row files
+};
+
+// bits in a room byte
+const unsigned char CELL_RIGHT = 1;   // can go right
+const unsigned char CELL_DOWN  = 2;   // can go down
+const int CELL_HEIGHT_SHIFT    = 4;   // the height is in the top 4 bits
+
+inline int cell_height(unsigned char cell) { return cell >> CELL_HEIGHT_SHIFT; }
+
+#endif // MAZEFILE_H
@@ -0,0 +1,133 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+/**
+ * A bounded lock free queue for any number of producers and consumers
+ * (Dmitry Vyukov's array queue).
+ *
+ * Every cell has a sequence number that says whose turn it is:
+ * a producer can fill cell i when seq == i, and a consumer
+ * can empty it when seq == i+1. Producers and consumers only
+ * contend on their own end of the queue.
+ */
+template<class T>
+class MpmcQueue
+{
+private:
+    struct Cell
+    {
+        atomic<size_t> seq;
+        T data;
+    };
+
+    unique_ptr<Cell[]> _cells;
+    size_t _mask;
+
+    // keep the two ends on separate cache lines
+    alignas(64) atomic<size_t> _tail;
+    alignas(64) atomic<size_t> _head;
+
+public:
+    /**
+     * @param capacity rounded up to a power of 2
+     */
+    explicit MpmcQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while(size < capacity)
+        {
+            size *= 2;
+        }
+        _cells.reset(new Cell[size]);
+        _mask = size - 1;
+        for(size_t i = 0; i < size; i++)
+        {
+            _cells[i].seq.store(i, memory_order_relaxed);
+        }
+        _tail.store(0, memory_order_relaxed);
+        _head.store(0, memory_order_relaxed);
+    }
+
+    /**
+     * @return false if the queue is full
+     */
+    bool try_push(const T& x)
+    {
+        size_t pos = _tail.load(memory_order_relaxed);
+        while(true)
+        {
+            Cell& cell = _cells[pos & _mask];
+            size_t seq = cell.seq.load(memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if(diff == 0)
+            {
+                if(_tail.compare_exchange_weak(pos, pos+1, memory_order_relaxed))
+                {
+                    cell.data = x;
+                    cell.seq.store(pos+1, memory_order_release);
+                    return true;
+                }
+            }
+            else if(diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = _tail.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @return false if the queue is empty
+     */
+    bool try_pop(T& x)
+    {
+        size_t pos = _head.load(memory_order_relaxed);
+        while(true)
+        {
+            Cell& cell = _cells[pos & _mask];
+            size_t seq = cell.seq.load(memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos+1);
+            if(diff == 0)
+            {
+                if(_head.compare_exchange_weak(pos, pos+1, memory_order_relaxed))
+                {
+                    x = cell.data;
+                    cell.seq.store(pos + _mask + 1, memory_order_release);
+                    return true;
+                }
+            }
+            else if(diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = _head.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * push, waiting for room if the queue is full
+     */
+    void push(const T& x)
+    {
+        while(!try_push(x))
+        {
+            this_thread::yield();
+        }
+    }
+};
+
+#endif // MPMC_QUEUE_H
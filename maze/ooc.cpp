@@ -0,0 +1,455 @@
+#include "ooc.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+// entries in each SpillQueue block
+const size_t SPILL_BLOCK = 8192;
+
+// bits in a state byte
+const unsigned char STATE_SETTLED = 0x80;
+const unsigned char STATE_DIR     = 0x07;
+
+/**
+ * read or write all of a buffer, even if the system call comes back short.
+ *
+ * @return the number of bytes actually moved
+ */
+static size_t read_all(int fd, void* buf, size_t n, off_t off)
+{
+    size_t done = 0;
+    while(done < n)
+    {
+        ssize_t got = pread(fd, (char*)buf + done, n - done, off + done);
+        if(got <= 0)
+        {
+            break;
+        }
+        done += got;
+    }
+    return done;
+}
+
+static size_t write_all(int fd, const void* buf, size_t n, off_t off)
+{
+    size_t done = 0;
+    while(done < n)
+    {
+        ssize_t put = pwrite(fd, (const char*)buf + done, n - done, off + done);
+        if(put <= 0)
+        {
+            break;
+        }
+        done += put;
+    }
+    return done;
+}
+
+/**
+ * Convert a row file into a tiled file, one band of tile rows at a time.
+ */
+bool tile_maze_file(const string& rows_file, const string& tiles_file, int64_t tile)
+{
+    int in = open(rows_file.c_str(), O_RDONLY);
+    if(in < 0)
+    {
+        return false;
+    }
+
+    MazeFileHeader header;
+    if(tile <= 0 ||
+       read_all(in, &header, sizeof(header), 0) != sizeof(header) ||
+       memcmp(header.magic, MAZE_ROWS_MAGIC, sizeof(header.magic)) != 0)
+    {
+        close(in);
+        return false;
+    }
+
+    int out = open(tiles_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(out < 0)
+    {
+        close(in);
+        return false;
+    }
+
+    int64_t rows = header.rows;
+    int64_t cols = header.cols;
+    int64_t across = (cols + tile-1) / tile;
+
+    memcpy(header.magic, MAZE_TILES_MAGIC, sizeof(header.magic));
+    header.tile = tile;
+    bool ok = write_all(out, &header, sizeof(header), 0) == sizeof(header);
+
+    // one band of rows in, and the same band as tiles out
+    vector<unsigned char> band(tile * cols);
+    vector<unsigned char> tiles(across * tile * tile);
+    off_t in_off = sizeof(header);
+    off_t out_off = sizeof(header);
+
+    for(int64_t r0 = 0; ok && r0 < rows; r0 += tile)
+    {
+        int64_t n = min(tile, rows - r0);
+        ok = read_all(in, band.data(), n * cols, in_off) == size_t(n * cols);
+        in_off += n * cols;
+
+        fill(tiles.begin(), tiles.end(), 0);
+        for(int64_t r = 0; r < n; r++)
+        {
+            for(int64_t t = 0; t < across; t++)
+            {
+                int64_t w = min(tile, cols - t*tile);
+                memcpy(&tiles[(t*tile + r) * tile], &band[r*cols + t*tile], w);
+            }
+        }
+
+        ok = ok && write_all(out, tiles.data(), tiles.size(), out_off) == tiles.size();
+        out_off += tiles.size();
+    }
+
+    close(in);
+    close(out);
+    return ok;
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// TileCache
+//
+////////////////////////////////////////////////////////////////////////
+
+TileCache::TileCache(int fd, off_t offset, int64_t cols, int64_t tile, int capacity)
+    : _fd(fd), _tile(tile), _tiles_across((cols + tile-1) / tile),
+      _tile_bytes(tile*tile), _offset(offset),
+      _data(max(1, capacity) * tile*tile), _last_tile(-1), _last_data(nullptr)
+{
+    _slots.reserve(max(1, capacity));
+}
+
+/**
+ * Find a tile in the cache, reading it in (and evicting the least
+ * recently used tile) if it isn't there.
+ *
+ * @param tile the tile number
+ * @param dirty if we're about to change the tile
+ * @return the data for the tile
+ */
+unsigned char* TileCache::load(int64_t tile, bool dirty)
+{
+    auto it = _where.find(tile);
+    int slot;
+    if(it != _where.end())
+    {
+        _stats.hits++;
+        slot = it->second;
+        _lru.splice(_lru.begin(), _lru, _slots[slot].lru);
+    }
+    else
+    {
+        _stats.misses++;
+        if(_slots.size() < _slots.capacity())
+        {
+            slot = _slots.size();
+            _lru.push_front(slot);
+            _slots.push_back(Slot{tile, false, _lru.begin()});
+        }
+        else
+        {
+            // evict the least recently used tile
+            slot = _lru.back();
+            _lru.splice(_lru.begin(), _lru, _slots[slot].lru);
+            Slot& old = _slots[slot];
+            if(old.dirty)
+            {
+                _stats.bytes_written += write_all(_fd, &_data[slot * _tile_bytes], _tile_bytes,
+                                                  _offset + old.tile * _tile_bytes);
+            }
+            _where.erase(old.tile);
+            old.tile = tile;
+            old.dirty = false;
+        }
+        _where[tile] = slot;
+
+        // anything past the end of the file reads as zeros
+        unsigned char* data = &_data[slot * _tile_bytes];
+        size_t got = read_all(_fd, data, _tile_bytes, _offset + tile * _tile_bytes);
+        memset(data + got, 0, _tile_bytes - got);
+        _stats.bytes_read += got;
+    }
+
+    _slots[slot].dirty |= dirty;
+    _last_tile = tile;
+    _last_data = &_data[slot * _tile_bytes];
+    return _last_data;
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// SpillQueue
+//
+////////////////////////////////////////////////////////////////////////
+
+SpillQueue::SpillQueue(size_t block, uint64_t* spilled)
+    : _block(block), _head_pos(0), _file(nullptr),
+      _read_off(0), _write_off(0), _size(0), _spilled(spilled)
+{
+}
+
+SpillQueue::SpillQueue(SpillQueue&& q)
+    : _block(q._block), _head(move(q._head)), _head_pos(q._head_pos),
+      _tail(move(q._tail)), _file(q._file), _read_off(q._read_off),
+      _write_off(q._write_off), _size(q._size), _spilled(q._spilled)
+{
+    q._file = nullptr;
+}
+
+SpillQueue::~SpillQueue()
+{
+    if(_file)
+    {
+        fclose(_file);
+    }
+}
+
+/**
+ * add x to the back of the queue.
+ * if the tail block is full, it gets written to the spill file.
+ */
+void SpillQueue::push(uint64_t x)
+{
+    if(_tail.size() == _block)
+    {
+        if(!_file)
+        {
+            _file = tmpfile();
+            if(!_file)
+            {
+                perror("tmpfile");
+                exit(1);
+            }
+        }
+        size_t bytes = _block * sizeof(uint64_t);
+        if(write_all(fileno(_file), _tail.data(), bytes, _write_off) != bytes)
+        {
+            perror("spill");
+            exit(1);
+        }
+        _write_off += bytes;
+        *_spilled += bytes;
+        _tail.clear();
+    }
+    _tail.push_back(x);
+    _size++;
+}
+
+/**
+ * remove the front of the queue.
+ * The queue must not be empty.
+ * Spilled blocks come back in the order they were written,
+ * and the tail block is only used once the file is drained.
+ */
+uint64_t SpillQueue::pop()
+{
+    if(_head_pos == _head.size())
+    {
+        _head_pos = 0;
+        if(_read_off < _write_off)
+        {
+            size_t bytes = _block * sizeof(uint64_t);
+            _head.resize(_block);
+            read_all(fileno(_file), _head.data(), bytes, _read_off);
+            _read_off += bytes;
+            if(_read_off == _write_off)
+            {
+                _read_off = _write_off = 0;
+            }
+        }
+        else
+        {
+            _head.swap(_tail);
+            _tail.clear();
+        }
+    }
+    _size--;
+    return _head[_head_pos++];
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// solver
+//
+////////////////////////////////////////////////////////////////////////
+
+// queue entries are a room and the direction back to where we came from:
+// 32 bits of row, 29 of column and 3 of direction.
+// Rows also have to fit in an int for the printed path.
+const int64_t MAX_OOC_ROWS = INT32_MAX;
+const int64_t MAX_OOC_COLS = int64_t(1) << 29;
+
+static uint64_t pack(int64_t r, int64_t c, int dir) { return (uint64_t(r) << 32) | (uint64_t(c) << 3) | dir; }
+static int64_t unpack_row(uint64_t x) { return x >> 32; }
+static int64_t unpack_col(uint64_t x) { return (x & 0xffffffff) >> 3; }
+static int unpack_dir(uint64_t x)     { return x & 7; }
+
+/**
+ * Dijkstra's algorithm (or bfs) over a tiled maze file.
+ *
+ * Costs are at most 15 (4 bit heights), so a ring of 16 buckets is enough:
+ * everything in the queue is within 15 of the current distance.
+ * We don't keep distances at all. A room can be in the queue more than once,
+ * and the first time it comes out is the cheapest, so that's when it's settled.
+ */
+bool solve_ooc(const string& tiles_file, bool weighted, int cache_tiles, OocStats& stats,
+               int64_t& length, int64_t& cost, path* p)
+{
+    length = 0;
+    cost = 0;
+    stats = OocStats();
+
+    int fd = open(tiles_file.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    MazeFileHeader header;
+    if(read_all(fd, &header, sizeof(header), 0) != sizeof(header) ||
+       memcmp(header.magic, MAZE_TILES_MAGIC, sizeof(header.magic)) != 0 ||
+       header.tile <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    int64_t rows = header.rows;
+    int64_t cols = header.cols;
+    int64_t tile = header.tile;
+    if(rows <= 0 || cols <= 0 || rows > MAX_OOC_ROWS || cols >= MAX_OOC_COLS)
+    {
+        cerr << tiles_file << " is " << rows << "x" << cols << ", the out of core solver only handles up to "
+             << MAX_OOC_ROWS << " rows and " << MAX_OOC_COLS-1 << " columns" << endl;
+        close(fd);
+        return false;
+    }
+    int64_t tiles = ((rows + tile-1) / tile) * ((cols + tile-1) / tile);
+
+    // the visited/parent byte for every room, in the same tiled layout
+    FILE* state_file = tmpfile();
+    if(!state_file || ftruncate(fileno(state_file), tiles * tile*tile) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    TileCache maze(fd, sizeof(header), cols, tile, cache_tiles);
+    TileCache state(fileno(state_file), 0, cols, tile, cache_tiles);
+
+    int nbuckets = weighted ? 16 : 1;
+    vector<SpillQueue> buckets;
+    for(int i = 0; i < nbuckets; i++)
+    {
+        buckets.emplace_back(SPILL_BLOCK, &stats.spilled_bytes);
+    }
+
+    buckets[0].push(pack(0, 0, FAIL));
+    uint64_t pending = 1;
+    int64_t d = 0;
+    bool found = false;
+
+    while(pending > 0 && !found)
+    {
+        SpillQueue& q = buckets[d % nbuckets];
+        if(q.empty())
+        {
+            d++;
+            continue;
+        }
+
+        uint64_t x = q.pop();
+        pending--;
+        int64_t r = unpack_row(x);
+        int64_t c = unpack_col(x);
+
+        if(state.get(r, c) & STATE_SETTLED)
+        {
+            continue;
+        }
+        state.set(r, c, STATE_SETTLED | unpack_dir(x));
+        stats.expanded++;
+
+        if(r == rows-1 && c == cols-1)
+        {
+            found = true;
+            break;
+        }
+
+        unsigned char cell = maze.get(r, c);
+        for(int dir = 0; dir < 4; dir++)
+        {
+            // left and up walls belong to the neighbor
+            bool open;
+            switch(dir)
+            {
+                case UP:    open = r > 0 && (maze.get(r-1, c) & CELL_DOWN);  break;
+                case LEFT:  open = c > 0 && (maze.get(r, c-1) & CELL_RIGHT); break;
+                case DOWN:  open = cell & CELL_DOWN;  break;
+                case RIGHT: open = cell & CELL_RIGHT; break;
+            }
+            if(!open)
+            {
+                continue;
+            }
+
+            auto [dr,dc] = moveIn(dir);
+            if(state.get(r+dr, c+dc) & STATE_SETTLED)
+            {
+                continue;
+            }
+
+            int step = weighted ? abs(cell_height(cell) - cell_height(maze.get(r+dr, c+dc))) : 1;
+            buckets[(d + (weighted ? step : 0)) % nbuckets].push(pack(r+dr, c+dc, opposite(dir)));
+            pending++;
+        }
+        stats.peak_queue = max(stats.peak_queue, pending);
+    }
+
+    if(found)
+    {
+        // follow the parents back to the start
+        int64_t r = rows-1;
+        int64_t c = cols-1;
+        int height = cell_height(maze.get(r, c));
+        while(true)
+        {
+            length++;
+            if(p)
+            {
+                p->push_front(make_pair(int(r), int(c)));
+            }
+
+            int dir = state.get(r, c) & STATE_DIR;
+            if(dir == FAIL)
+            {
+                break;
+            }
+            auto [dr,dc] = moveIn(dir);
+            r += dr;
+            c += dc;
+
+            int next = cell_height(maze.get(r, c));
+            cost += weighted ? abs(height - next) : 1;
+            height = next;
+        }
+    }
+
+    stats.maze = maze.stats();
+    stats.state = state.stats();
+    fclose(state_file);
+    close(fd);
+    return true;
+}
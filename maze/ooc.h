@@ -0,0 +1,171 @@
+#ifndef OOC_H
+#define OOC_H
+
+#include "mazefile.h"
+#include "path.h"
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+using namespace std;
+
+/**
+ * Convert a row file (from gen_eller_file) into a tiled file.
+ * Only tile rows of the maze are in memory at a time.
+ *
+ * @param rows_file the row file to read
+ * @param tiles_file the tiled file to write
+ * @param tile the width and height of a tile
+ * @return false if either file couldn't be used
+ */
+bool tile_maze_file(const string& rows_file, const string& tiles_file, int64_t tile);
+
+/**
+ * Counters for a TileCache, used to tune the tile size.
+ */
+struct TileStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+};
+
+/**
+ * A bounded LRU cache of tiles from a tiled file.
+ * Tiles are read with pread when they're needed,
+ * and written back with pwrite when they're evicted (if they were changed).
+ */
+class TileCache
+{
+private:
+    struct Slot
+    {
+        int64_t tile;
+        bool dirty;
+        list<int>::iterator lru;
+    };
+
+    int _fd;
+    int64_t _tile;
+    int64_t _tiles_across;
+    int64_t _tile_bytes;
+    off_t _offset;
+
+    // tile data for every slot, slot i is at _data[i*_tile_bytes]
+    vector<unsigned char> _data;
+    vector<Slot> _slots;
+    unordered_map<int64_t, int> _where;
+    list<int> _lru;   // most recently used slot first
+
+    // the last tile we looked at, most accesses are to the same tile
+    int64_t _last_tile;
+    unsigned char* _last_data;
+
+    TileStats _stats;
+
+    unsigned char* load(int64_t tile, bool dirty);
+
+public:
+    /**
+     * @param fd an open file with the tiles in it
+     * @param offset where the first tile starts in the file
+     * @param cols number of columns of rooms
+     * @param tile the width and height of a tile
+     * @param capacity the most tiles to keep in memory
+     */
+    TileCache(int fd, off_t offset, int64_t cols, int64_t tile, int capacity);
+
+    /**
+     * @return the byte for room (r,c)
+     */
+    unsigned char get(int64_t r, int64_t c)
+    {
+        int64_t t = (r / _tile) * _tiles_across + c / _tile;
+        unsigned char* data = t == _last_tile ? (_stats.hits++, _last_data) : load(t, false);
+        return data[(r % _tile) * _tile + c % _tile];
+    }
+
+    /**
+     * set the byte for room (r,c)
+     */
+    void set(int64_t r, int64_t c, unsigned char val)
+    {
+        int64_t t = (r / _tile) * _tiles_across + c / _tile;
+        load(t, true)[(r % _tile) * _tile + c % _tile] = val;
+    }
+
+    const TileStats& stats() const { return _stats; }
+};
+
+/**
+ * A FIFO queue that keeps at most two blocks in memory
+ * and spills everything in between to a temporary file.
+ */
+class SpillQueue
+{
+private:
+    size_t _block;
+    vector<uint64_t> _head;
+    size_t _head_pos;
+    vector<uint64_t> _tail;
+    FILE* _file;
+    off_t _read_off;
+    off_t _write_off;
+    uint64_t _size;
+    uint64_t* _spilled;
+
+public:
+    /**
+     * @param block number of entries in a block
+     * @param spilled counter to add the number of bytes spilled to
+     */
+    SpillQueue(size_t block, uint64_t* spilled);
+    SpillQueue(SpillQueue&& q);
+    ~SpillQueue();
+
+    void push(uint64_t x);
+    uint64_t pop();
+    bool empty() const { return _size == 0; }
+};
+
+/**
+ * Counters from an out of core solve.
+ */
+struct OocStats
+{
+    TileStats maze;
+    TileStats state;
+    uint64_t expanded = 0;
+    uint64_t spilled_bytes = 0;
+    uint64_t peak_queue = 0;
+};
+
+/**
+ * Find a path from (0,0) to (rows-1,cols-1) in a tiled maze file
+ * without loading the whole maze.
+ *
+ * The search is dijkstra's algorithm with a bucket queue (or bfs if weighted is false).
+ * The buckets are SpillQueues, and the visited/parent information for each room
+ * lives in a temporary tiled file behind its own TileCache.
+ *
+ * @param tiles_file the tiled maze
+ * @param weighted use height differences as the cost, otherwise every move costs 1
+ * @param cache_tiles the most tiles to keep in memory for each cache
+ * @param stats filled in with the counters
+ * @param length set to the number of rooms on the path, 0 if there isn't one
+ * @param cost set to the cost of the path
+ * @param p if not null, filled in with the path.
+ *          Only use this if the path fits in memory.
+ * @return false if the file couldn't be read,
+ *         or the maze is too big to pack a room into a queue entry
+ *         (2^31-1 rows or 2^29-1 columns at most)
+ */
+bool solve_ooc(const string& tiles_file, bool weighted, int cache_tiles, OocStats& stats,
+               int64_t& length, int64_t& cost, path* p);
+
+#endif // OOC_H
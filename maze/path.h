@@ -17,36 +17,31 @@ const int DOWN  = 2;
 const int RIGHT = 3;
 const int FAIL  = 4;
 
-inline int opposite(const int dir)
+// per direction tables, so code that knows the direction at compile time
+// can look things up without a switch.
+constexpr int DIR_DR[4]       = {-1, 0, 1, 0};
+constexpr int DIR_DC[4]       = {0, -1, 0, 1};
+constexpr int DIR_OPPOSITE[4] = {DOWN, RIGHT, UP, LEFT};
+
+constexpr int opposite(const int dir)
 {
-    switch(dir)
-    {
-        case UP:    return DOWN;
-        case LEFT:  return RIGHT;
-        case DOWN:  return UP;
-        case RIGHT: return LEFT;
-    }
-    return FAIL;
+    return unsigned(dir) < 4 ? DIR_OPPOSITE[dir] : FAIL;
 }
 
-inline point moveIn(const int dir)
+constexpr point moveIn(const int dir)
 {
-    switch(dir)
-    {
-        case UP:    return make_pair(-1,0);
-        case LEFT:  return make_pair(0,-1);
-        case DOWN:  return make_pair(1,0);
-        case RIGHT: return make_pair(0,1);
-    }
-    return make_pair(-1,-1);
+    return unsigned(dir) < 4 ? point(DIR_DR[dir], DIR_DC[dir]) : point(-1,-1);
 }
 
-inline int direction(const point& p1, const point& p2)
+// the direction to go from p1 to p2, or FAIL if they aren't neighbors
+constexpr int direction(const point& p1, const point& p2)
 {
-    if(p1.first  - p2.first  == 1)  return UP;
-    if(p1.first  - p2.first  == -1) return DOWN;
-    if(p1.second - p2.second == 1)  return LEFT;
-    if(p1.second - p2.second == -1) return RIGHT;
+    int dr = p2.first  - p1.first;
+    int dc = p2.second - p1.second;
+    if(dr == -1 && dc == 0) return UP;
+    if(dr == 1  && dc == 0) return DOWN;
+    if(dr == 0  && dc == -1) return LEFT;
+    if(dr == 0  && dc == 1)  return RIGHT;
     return FAIL;
 }
 
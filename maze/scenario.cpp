@@ -0,0 +1,50 @@
+#include "scenario.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+static Scenario make_scenario(const string& name, double delete_frac, int max_height,
+                              HeightDist dist, double aspect)
+{
+    Scenario s;
+    s.name = name;
+    s.params.delete_frac = delete_frac;
+    s.params.min_height = 0;
+    s.params.max_height = max_height;
+    s.params.height_dist = dist;
+    s.aspect = aspect;
+    return s;
+}
+
+const vector<Scenario>& scenario_suite()
+{
+    static const vector<Scenario> suite = {
+        make_scenario("default",       0.1, 9,   HeightDist::UNIFORM, 1),
+        make_scenario("perfect-maze",  0,   9,   HeightDist::UNIFORM, 1),
+        make_scenario("open-field",    0.8, 9,   HeightDist::UNIFORM, 1),
+        make_scenario("tall-skinny",   0.1, 9,   HeightDist::UNIFORM, 64),
+        make_scenario("steep-terrain", 0.1, 254, HeightDist::UNIFORM, 1),
+        make_scenario("rolling-hills", 0.3, 50,  HeightDist::NORMAL,  1),
+    };
+    return suite;
+}
+
+const Scenario* find_scenario(const string& name)
+{
+    for(auto& s : scenario_suite())
+    {
+        if(s.name == name)
+        {
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+void scenario_shape(const Scenario& s, long long cells, int& rows, int& cols)
+{
+    // rows*cols = cells and rows = aspect*cols
+    cols = max(1, int(lround(sqrt(cells / s.aspect))));
+    rows = max(1, int(lround(double(cells) / cols)));
+}
@@ -0,0 +1,43 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "maze.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * A named kind of maze for benchmarks:
+ * the generator's parameters and the shape of the grid.
+ */
+struct Scenario
+{
+    string name;
+    MazeParams params;
+    // rows per column
+    double aspect;
+};
+
+/**
+ * The benchmark suite:
+ *   default        the original generator
+ *   perfect-maze   no loops, exactly one path between any two rooms
+ *   open-field     most of the walls knocked down
+ *   tall-skinny    64 times as many rows as columns
+ *   steep-terrain  heights from 0 to 254, so costs vary a lot
+ *   rolling-hills  normally distributed heights 0 to 50
+ */
+const vector<Scenario>& scenario_suite();
+
+/**
+ * @return the scenario called name, or null
+ */
+const Scenario* find_scenario(const string& name);
+
+/**
+ * Pick rows and columns with about cells rooms in the scenario's aspect ratio.
+ */
+void scenario_shape(const Scenario& s, long long cells, int& rows, int& cols);
+
+#endif // SCENARIO_H
@@ -0,0 +1,183 @@
+#include "scheduler.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+static double now_ms()
+{
+    using namespace chrono;
+    return duration<double, milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * A kernel search with its own workspace.
+ * The workspace is declared first, so it's built before the search takes hold of it.
+ */
+template<class Frontier, class Cost>
+class KernelTask : public SolveTask
+{
+private:
+    SolverWorkspace _ws;
+    Search<Frontier, Cost, RoomGoal> _search;
+    int _src;
+    int _goal;
+
+public:
+    KernelTask(const Cost& cost, int src, int goal, RunStats* stats)
+        : _search(cost, _ws, src, RoomGoal{goal}, stats), _src(src), _goal(goal) {}
+
+    SearchStatus step(size_t budget) override { return _search.step(budget); }
+    SearchStatus status() const override      { return _search.status(); }
+
+    void partial() override
+    {
+        if(_search.status() != SearchStatus::FOUND)
+        {
+            _search.partial_path(_goal < 0 ? _src : _goal);
+        }
+    }
+
+    const SolverWorkspace& workspace() const override { return _ws; }
+};
+
+unique_ptr<SolveTask> dfs_task(const Maze& m, int src, int goal, RunStats* stats)
+{
+    return make_unique<KernelTask<StackFrontier, UnitCost>>(UnitCost{m}, src, goal, stats);
+}
+
+unique_ptr<SolveTask> bfs_task(const Maze& m, int src, int goal, RunStats* stats)
+{
+    return make_unique<KernelTask<FifoFrontier, UnitCost>>(UnitCost{m}, src, goal, stats);
+}
+
+unique_ptr<SolveTask> dijkstra_task(const EdgeCosts& e, int src, int goal, RunStats* stats)
+{
+    return make_unique<KernelTask<BucketFrontier, HeightCost>>(HeightCost(e), src, goal, stats);
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// scheduler
+//
+////////////////////////////////////////////////////////////////////////
+
+SolveScheduler::SolveScheduler(double slice_ms, size_t chunk)
+    : _slice_ms(slice_ms), _chunk(max<size_t>(1, chunk)), _waiting(0)
+{
+}
+
+void SolveScheduler::finish(Job& job, JobState state, double now)
+{
+    if(state == JobState::CANCELLED || state == JobState::TIMED_OUT)
+    {
+        job.task->partial();
+    }
+    job.state = state;
+    job.finished = now;
+    _waiting--;
+}
+
+int SolveScheduler::add(unique_ptr<SolveTask> task, double deadline_ms)
+{
+    double now = now_ms();
+    Job job{move(task), JobState::WAITING, now, deadline_ms > 0 ? now + deadline_ms : 0, now, 0};
+    int id;
+    if(_free.empty())
+    {
+        id = _jobs.size();
+        _jobs.push_back(move(job));
+    }
+    else
+    {
+        id = _free.back();
+        _free.pop_back();
+        _jobs[id] = move(job);
+    }
+    _waiting++;
+    _ready.push_back(id);
+    return id;
+}
+
+bool SolveScheduler::cancel(int id)
+{
+    if(id < 0 || size_t(id) >= _jobs.size() || _jobs[id].state != JobState::WAITING)
+    {
+        return false;
+    }
+    // take it out of the line now, so the id can be reused once it's released
+    _ready.erase(find(_ready.begin(), _ready.end(), id));
+    finish(_jobs[id], JobState::CANCELLED, now_ms());
+    return true;
+}
+
+unique_ptr<SolveTask> SolveScheduler::release(int id)
+{
+    if(id < 0 || size_t(id) >= _jobs.size() || !_jobs[id].task || _jobs[id].state == JobState::WAITING)
+    {
+        return nullptr;
+    }
+    _free.push_back(id);
+    return move(_jobs[id].task);
+}
+
+bool SolveScheduler::run_once()
+{
+    if(_ready.empty())
+    {
+        return false;
+    }
+
+    int id = _ready.front();
+    _ready.pop_front();
+    Job& job = _jobs[id];
+
+    // its deadline may have passed while it waited in line
+    double now = now_ms();
+    if(job.deadline > 0 && now >= job.deadline)
+    {
+        finish(job, JobState::TIMED_OUT, now);
+        return true;
+    }
+    job.slices++;
+
+    double end = now + _slice_ms;
+    if(job.deadline > 0)
+    {
+        end = min(end, job.deadline);
+    }
+
+    // always at least one chunk, so every job gets somewhere
+    SearchStatus s;
+    do
+    {
+        s = job.task->step(_chunk);
+        now = now_ms();
+    }
+    while(s == SearchStatus::RUNNING && now < end);
+
+    if(s == SearchStatus::FOUND)
+    {
+        finish(job, JobState::FOUND, now);
+    }
+    else if(s == SearchStatus::EXHAUSTED)
+    {
+        finish(job, JobState::EXHAUSTED, now);
+    }
+    else if(job.deadline > 0 && now >= job.deadline)
+    {
+        finish(job, JobState::TIMED_OUT, now);
+    }
+    else
+    {
+        _ready.push_back(id);
+    }
+    return true;
+}
+
+void SolveScheduler::run()
+{
+    while(run_once())
+    {
+    }
+}
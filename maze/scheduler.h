@@ -0,0 +1,155 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "maze.h"
+#include "path.h"
+#include "edge_costs.h"
+#include "kernel.h"
+#include "workspace.h"
+#include "stats.h"
+#include <deque>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/**
+ * One search that can be run a bit at a time, whatever its policies are.
+ * Each task has its own workspace, so any number of them can be part way through.
+ */
+class SolveTask
+{
+public:
+    virtual ~SolveTask() {}
+
+    /**
+     * take up to budget rooms off the frontier
+     */
+    virtual SearchStatus step(size_t budget) = 0;
+
+    virtual SearchStatus status() const = 0;
+
+    /**
+     * leave the best path so far in the workspace:
+     * the whole path if the goal was found,
+     * otherwise the path to the room seen so far that's closest to the goal
+     */
+    virtual void partial() = 0;
+
+    virtual const SolverWorkspace& workspace() const = 0;
+};
+
+/**
+ * Tasks for the searches in solvers.h, from src to goal (rooms numbered r*cols + c).
+ * The maze (or edge costs) has to outlive the task.
+ */
+unique_ptr<SolveTask> dfs_task(const Maze& m, int src, int goal, RunStats* stats = nullptr);
+unique_ptr<SolveTask> bfs_task(const Maze& m, int src, int goal, RunStats* stats = nullptr);
+unique_ptr<SolveTask> dijkstra_task(const EdgeCosts& e, int src, int goal, RunStats* stats = nullptr);
+
+// what happened to a job
+enum class JobState
+{
+    WAITING,    // still has slices to run
+    FOUND,      // the path is in the task's workspace
+    EXHAUSTED,  // the goal can't be reached
+    CANCELLED,  // stopped by cancel(), the workspace has a partial path
+    TIMED_OUT   // ran past its deadline, the workspace has a partial path
+};
+
+/**
+ * Runs many searches on one thread, round robin,
+ * each one getting a time slice before going to the back of the line.
+ *
+ * A small search finishes after at most one slice for each job ahead of it,
+ * however big the other searches are.
+ * The clock is checked every chunk rooms, so a slice can run over by one chunk.
+ *
+ * A finished job keeps its task (and the task's workspace) until release() hands it back,
+ * then its id goes to the next job added.
+ */
+class SolveScheduler
+{
+private:
+    struct Job
+    {
+        unique_ptr<SolveTask> task;
+        JobState state;
+        double added;       // ms
+        double deadline;    // ms, 0 for none
+        double finished;    // ms
+        size_t slices;
+    };
+
+    double _slice_ms;
+    size_t _chunk;
+    vector<Job> _jobs;
+    vector<int> _free;      // released ids, to reuse
+    deque<int> _ready;
+    size_t _waiting;
+
+    void finish(Job& job, JobState state, double now);
+
+public:
+    /**
+     * @param slice_ms how long each job runs before the next one gets a turn
+     * @param chunk number of rooms between looks at the clock
+     */
+    explicit SolveScheduler(double slice_ms = 1.0, size_t chunk = 256);
+
+    /**
+     * add a job at the back of the line
+     *
+     * @param deadline_ms stop the job this long from now, 0 for no deadline
+     * @return the job's id
+     */
+    int add(unique_ptr<SolveTask> task, double deadline_ms = 0);
+
+    /**
+     * stop a job that hasn't finished and keep its best partial path.
+     *
+     * @return false if the job had already finished
+     */
+    bool cancel(int id);
+
+    /**
+     * Take a finished job's task back, to read its path, and forget the job.
+     * The id (and the state, latency, and slices that go with it) can't be used after this.
+     *
+     * @return the task, or null if the job hasn't finished
+     */
+    unique_ptr<SolveTask> release(int id);
+
+    /**
+     * give the job at the front of the line one slice
+     *
+     * @return false if there was nothing left to run
+     */
+    bool run_once();
+
+    /**
+     * run slices until every job has finished.
+     * A job past its deadline times out before it gets another slice.
+     */
+    void run();
+
+    /**
+     * @return the number of jobs that haven't finished
+     */
+    size_t waiting() const { return _waiting; }
+
+    JobState state(int id) const          { return _jobs[id].state; }
+    const SolveTask& task(int id) const   { return *_jobs[id].task; }
+
+    /**
+     * @return ms from adding the job to it finishing (or being cancelled)
+     */
+    double latency_ms(int id) const { return _jobs[id].finished - _jobs[id].added; }
+
+    /**
+     * @return the number of slices the job got
+     */
+    size_t slices(int id) const { return _jobs[id].slices; }
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,99 @@
+#include "solvers.h"
+#include "kernel.h"
+#include "tour.h"
+#include "validate.h"
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// The searches are all the same loop (see kernel.h) with different policies.
+
+template<class Layout>
+bool dfs_search(const BasicMaze<Layout>& m, SolverWorkspace& ws, int src, int goal, RunStats* stats)
+{
+    return search_kernel<StackFrontier>(BasicUnitCost<Layout>(m), ws, src, RoomGoal{goal}, stats);
+}
+
+template<class Layout>
+bool bfs_search(const BasicMaze<Layout>& m, SolverWorkspace& ws, int src, int goal, RunStats* stats)
+{
+    return search_kernel<FifoFrontier>(BasicUnitCost<Layout>(m), ws, src, RoomGoal{goal}, stats);
+}
+
+bool dijkstra_search(const EdgeCosts& e, SolverWorkspace& ws, int src, int goal, RunStats* stats)
+{
+    return search_kernel<BucketFrontier>(HeightCost(e), ws, src, RoomGoal{goal}, stats);
+}
+
+// every layout the maze is built with
+template bool dfs_search(const BasicMaze<RowMajorLayout>&, SolverWorkspace&, int, int, RunStats*);
+template bool dfs_search(const BasicMaze<TiledLayout<8>>&, SolverWorkspace&, int, int, RunStats*);
+template bool dfs_search(const BasicMaze<TiledLayout<16>>&, SolverWorkspace&, int, int, RunStats*);
+template bool dfs_search(const BasicMaze<MortonLayout>&, SolverWorkspace&, int, int, RunStats*);
+template bool bfs_search(const BasicMaze<RowMajorLayout>&, SolverWorkspace&, int, int, RunStats*);
+template bool bfs_search(const BasicMaze<TiledLayout<8>>&, SolverWorkspace&, int, int, RunStats*);
+template bool bfs_search(const BasicMaze<TiledLayout<16>>&, SolverWorkspace&, int, int, RunStats*);
+template bool bfs_search(const BasicMaze<MortonLayout>&, SolverWorkspace&, int, int, RunStats*);
+
+////////////////////////////////////////////////////////////////////////
+//
+// original interface
+//
+////////////////////////////////////////////////////////////////////////
+
+path solve_dfs(Maze& m, int rows, int cols, RunStats* stats)
+{
+    SolverWorkspace ws;
+    STAT(stats, begin_phase("search"));
+    dfs_search(m, ws, 0, rows*cols - 1, stats);
+    STAT(stats, end_phase());
+
+    STAT(stats, begin_phase("path"));
+    path return_path = ws.to_list();
+    STAT(stats, end_phase());
+    cout << "Size of path: " << return_path.size() << endl;
+    return return_path;
+}
+
+path solve_bfs(Maze& m, int rows, int cols, RunStats* stats)
+{
+    SolverWorkspace ws;
+    STAT(stats, begin_phase("search"));
+    bfs_search(m, ws, 0, rows*cols - 1, stats);
+    STAT(stats, end_phase());
+
+    STAT(stats, begin_phase("path"));
+    path return_path = ws.to_list();
+    STAT(stats, end_phase());
+    cout << "Size of path: " << return_path.size() << endl;
+    return return_path;
+}
+
+path solve_dijkstra(Maze& m, int rows, int cols, RunStats* stats)
+{
+    STAT(stats, begin_phase("edge costs"));
+    EdgeCosts costs(m);
+    STAT(stats, end_phase());
+
+    SolverWorkspace ws;
+    STAT(stats, begin_phase("search"));
+    dijkstra_search(costs, ws, 0, rows*cols - 1, stats);
+    STAT(stats, end_phase());
+
+    STAT(stats, begin_phase("path"));
+    path return_path = ws.to_list();
+    STAT(stats, end_phase());
+    cout << "Size of path: " << return_path.size() << endl;
+    return return_path;
+}
+
+//The order and the legs between corners come from the general waypoint tour.
+path solve_tour(Maze& m, int rows, int cols, RunStats* stats)
+{
+    int cost;
+    path return_path = solve_waypoint_tour(m, corner_waypoints(rows, cols), cost, stats);
+    cout << "Size of path: " << return_path.size() << endl;
+    return return_path;
+}
@@ -0,0 +1,50 @@
+#ifndef SOLVERS_H
+#define SOLVERS_H
+
+#include "maze.h"
+#include "path.h"
+#include "edge_costs.h"
+#include "workspace.h"
+#include "stats.h"
+
+/**
+ * Searches that keep all of their state in a SolverWorkspace,
+ * so a loop of solves can reuse one workspace without touching the heap.
+ *
+ * Rooms are numbered by their index in the maze's layout,
+ * m.layout().index(r,c), which is r*cols + c for the row major Maze.
+ * A search goes from src until it reaches goal (or everything, if goal is -1).
+ * If it finds goal, the path is left in the workspace.
+ *
+ * @return if goal was reached
+ */
+
+// depth first search: a stack search that marks rooms when they're pushed,
+// not a backtracking walk, so the path isn't always the one a backtracker finds
+// dfs and bfs are built for every layout in layout.h.
+template<class Layout>
+bool dfs_search(const BasicMaze<Layout>& m, SolverWorkspace& ws, int src, int goal, RunStats* stats = nullptr);
+
+// breadth first search, the path has the fewest rooms
+template<class Layout>
+bool bfs_search(const BasicMaze<Layout>& m, SolverWorkspace& ws, int src, int goal, RunStats* stats = nullptr);
+
+// dijkstra's algorithm over the edge cost planes, the path has the lowest cost
+bool dijkstra_search(const EdgeCosts& e, SolverWorkspace& ws, int src, int goal, RunStats* stats = nullptr);
+
+/**
+ * The original solver interface.
+ * Each one solves from (0,0) to (rows-1,cols-1) with a fresh workspace,
+ * prints the size of the path, and returns it as a list.
+ * The stats are optional (see stats.h).
+ */
+path solve_dfs(Maze& m, int rows, int cols, RunStats* stats = nullptr);
+path solve_bfs(Maze& m, int rows, int cols, RunStats* stats = nullptr);
+path solve_dijkstra(Maze& m, int rows, int cols, RunStats* stats = nullptr);
+
+/**
+ * All corners tour: start in the center, visit the four corners, and come back.
+ */
+path solve_tour(Maze& m, int rows, int cols, RunStats* stats = nullptr);
+
+#endif // SOLVERS_H
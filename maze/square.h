@@ -1,7 +1,6 @@
 #ifndef SQUARE_H
 #define SQUARE_H
 
-#include<vector>
 #include "path.h"
 
 /**
@@ -13,22 +12,27 @@ class Square
 {
 private:
     // am I allowed to go up down left or right?
-    vector<bool> _walls;
+    // bit dir is set if we can go in direction dir.
+    // A bitmask keeps the square small and inline in the maze's array,
+    // so the cell layout actually decides where the walls live in memory.
+    unsigned char _walls;
     int _height;
     
 public:
     //The default square is completely isolated.
-    Square()           : _walls(4,false), _height(0) {}
-    Square(int height) : _walls(4,false), _height(height) {}
-    Square(const Square& s) : _walls(s._walls), _height(s._height) {}
+    Square()           : _walls(0), _height(0) {}
+    Square(int height) : _walls(0), _height(height) {}
 
     // Used for setting up the maze.
     // Set's the boarders for the square.
-    void set_dir(bool val, int dir)  {_walls[dir]   = val;}
+    void set_dir(bool val, int dir)
+    {
+        _walls = val ? (_walls | (1 << dir)) : (_walls & ~(1 << dir));
+    }
     void set_height(int height)      {_height       = height;}
 
     // check if you can go in any of these directions.
-    bool can_go_dir(int dir) const  {return _walls[dir];}
+    bool can_go_dir(int dir) const  {return (_walls >> dir) & 1;}
     int height() const              {return _height;}
 };
 
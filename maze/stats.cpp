@@ -0,0 +1,176 @@
+#include "stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+using namespace std;
+
+#ifdef MAZE_STATS
+
+static thread_local uint64_t bytes_allocated = 0;
+
+// count every allocation, so phases can report how much they allocated
+void* operator new(size_t n)
+{
+    bytes_allocated += n;
+    void* p = malloc(n ? n : 1);
+    if(!p)
+    {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+uint64_t thread_bytes_allocated()
+{
+    return bytes_allocated;
+}
+
+#else
+
+uint64_t thread_bytes_allocated()
+{
+    return 0;
+}
+
+#endif
+
+/**
+ * @return microseconds since the program started
+ */
+static double now_us()
+{
+    using namespace chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return duration<double, micro>(steady_clock::now() - start).count();
+}
+
+void RunStats::add(const RunStats& s)
+{
+    expanded += s.expanded;
+    pushes += s.pushes;
+    pops += s.pops;
+    peak_frontier = max(peak_frontier, s.peak_frontier);
+    if(!phases.empty() && phases.back().dur_us < 0)
+    {
+        // the phase's bytes are still its start counter,
+        // so moving the start back counts s's bytes when the phase ends
+        phases.back().bytes -= s.bytes_allocated;
+    }
+    else
+    {
+        bytes_allocated += s.bytes_allocated;
+    }
+}
+
+/**
+ * start timing a phase.
+ * The bytes field holds the allocation counter until the phase ends.
+ */
+void RunStats::begin_phase(const string& phase)
+{
+    phases.push_back(Phase{phase, now_us(), -1, thread_bytes_allocated()});
+}
+
+void RunStats::end_phase()
+{
+    if(phases.empty() || phases.back().dur_us >= 0)
+    {
+        return;
+    }
+    Phase& p = phases.back();
+    p.dur_us = now_us() - p.start_us;
+    p.bytes = thread_bytes_allocated() - p.bytes;
+    bytes_allocated += p.bytes;
+}
+
+double RunStats::total_us() const
+{
+    double total = 0;
+    for(const Phase& p : phases)
+    {
+        total += max(0.0, p.dur_us);
+    }
+    return total;
+}
+
+void RunStats::print(ostream& out) const
+{
+    out << name << ": expanded " << expanded
+        << ", pushes " << pushes
+        << ", pops " << pops
+        << ", peak frontier " << peak_frontier
+        << ", bytes allocated " << bytes_allocated << endl;
+    for(const Phase& p : phases)
+    {
+        out << "  " << p.name << ": " << fixed << setprecision(1) << p.dur_us << "us, "
+            << p.bytes << " bytes" << endl;
+    }
+}
+
+/**
+ * Escape a string for JSON, the names are ours so only quotes and backslashes matter.
+ */
+static string json_string(const string& s)
+{
+    string out = "\"";
+    for(char ch : s)
+    {
+        if(ch == '"' || ch == '\\')
+        {
+            out += '\\';
+        }
+        out += ch;
+    }
+    return out + "\"";
+}
+
+void write_trace(ostream& out, const list<RunStats>& runs)
+{
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    size_t t = 0;
+    for(auto it = runs.begin(); it != runs.end(); it++, t++)
+    {
+        const RunStats& s = *it;
+
+        // name the thread after the run
+        out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << t
+            << ",\"args\":{\"name\":" << json_string(s.name) << "}}";
+        first = false;
+
+        for(size_t i = 0; i < s.phases.size(); i++)
+        {
+            const RunStats::Phase& p = s.phases[i];
+            out << ",\n{\"name\":" << json_string(p.name)
+                << ",\"cat\":" << json_string(s.name)
+                << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << t
+                << fixed << setprecision(3)
+                << ",\"ts\":" << p.start_us
+                << ",\"dur\":" << max(0.0, p.dur_us)
+                << ",\"args\":{\"bytes\":" << p.bytes;
+            if(i == 0)
+            {
+                out << ",\"expanded\":" << s.expanded
+                    << ",\"pushes\":" << s.pushes
+                    << ",\"pops\":" << s.pops
+                    << ",\"peak_frontier\":" << s.peak_frontier
+                    << ",\"bytes_allocated\":" << s.bytes_allocated;
+            }
+            out << "}}";
+        }
+    }
+    out << "\n]}" << endl;
+}
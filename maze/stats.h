@@ -0,0 +1,96 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Counters for one run of a solver (or of the maze generator).
+ *
+ * Solvers take a RunStats* and only touch it through the STAT macros below.
+ * Unless the program is built with MAZE_STATS (make stats, make debug)
+ * the macros only mark s as used, so a release build doesn't pay for them at all.
+ *
+ * Allocations are counted per thread, so a phase counts what its own thread allocates.
+ * Work handed to other threads is counted by adding their RunStats in with add()
+ * before the phase ends.
+ */
+struct RunStats
+{
+    // one timed phase of a run
+    struct Phase
+    {
+        string name;
+        double start_us;
+        double dur_us;
+        uint64_t bytes;
+    };
+
+    string name;
+    uint64_t expanded = 0;        // rooms taken off the frontier and looked at
+    uint64_t pushes = 0;          // rooms added to the frontier
+    uint64_t pops = 0;            // rooms taken off the frontier (including stale ones)
+    uint64_t peak_frontier = 0;   // biggest the frontier got
+    uint64_t bytes_allocated = 0; // bytes from operator new during the phases
+    vector<Phase> phases;
+
+    RunStats(const string& name = "") : name(name) {}
+
+    void push(size_t frontier)
+    {
+        pushes++;
+        if(frontier > peak_frontier)
+        {
+            peak_frontier = frontier;
+        }
+    }
+
+    /**
+     * add the counters from another run (used to combine worker threads).
+     * s's bytes_allocated go to the phase that's running, if there is one.
+     */
+    void add(const RunStats& s);
+
+    void begin_phase(const string& phase);
+    void end_phase();
+
+    /**
+     * @return the total time of all the phases in microseconds
+     */
+    double total_us() const;
+
+    /**
+     * print the counters in a human readable format
+     */
+    void print(ostream& out) const;
+};
+
+/**
+ * Write a set of runs as a Chrome trace (load it in chrome://tracing or Perfetto).
+ * Each run is a thread, with one event per phase.
+ * The counters go in the args of the first phase.
+ */
+void write_trace(ostream& out, const list<RunStats>& runs);
+
+/**
+ * @return the bytes this thread has allocated with operator new so far,
+ *         always 0 without MAZE_STATS
+ */
+uint64_t thread_bytes_allocated();
+
+#ifdef MAZE_STATS
+#define STAT(s, call)      do { if(s) (s)->call; } while(0)
+#define STAT_ADD(s, field, n) do { if(s) (s)->field += (n); } while(0)
+#else
+// the counters compile out, but s still counts as used
+#define STAT(s, call)      do { (void)(s); } while(0)
+#define STAT_ADD(s, field, n) do { (void)(s); } while(0)
+#endif
+
+#endif // STATS_H
@@ -0,0 +1,320 @@
+#include "tour.h"
+#include "solvers.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// ints in an SSE register, the Held-Karp rows are padded to a multiple of this
+const int LANES = 4;
+
+/**
+ * Compute the cost of the cheapest path between every pair of waypoints.
+ * Each worker thread grabs the next waypoint that hasn't been searched yet.
+ */
+vector<int> waypoint_costs(const Maze& m, const vector<point>& waypoints,
+                           vector<vector<unsigned char>>* parents,
+                           RunStats* stats, int threads)
+{
+    int n = waypoints.size();
+    int cols = m.columns();
+    vector<int> costs(n*n, TOUR_INF);
+
+    if(parents)
+    {
+        parents->assign(n, vector<unsigned char>());
+    }
+
+    // every search shares the same edge costs
+    EdgeCosts edges(m);
+
+    atomic<int> next(0);
+    mutex stats_lock;
+    auto worker = [&](bool helper)
+    {
+        // each thread counts on its own and adds its counters in at the end.
+        // The calling thread's allocations are already counted by its phase,
+        // a helper thread's are added in with its other counters
+        RunStats* local_stats = nullptr;
+#ifdef MAZE_STATS
+        RunStats local;
+        local_stats = stats ? &local : nullptr;
+        uint64_t start_bytes = thread_bytes_allocated();
+#else
+        (void)helper;
+        (void)stats;
+#endif
+        SolverWorkspace ws;
+        for(int i = next++; i < n; i = next++)
+        {
+            dijkstra_search(edges, ws, waypoints[i].first*cols + waypoints[i].second, -1, local_stats);
+            for(int j = 0; j < n; j++)
+            {
+                int cell = waypoints[j].first*cols + waypoints[j].second;
+                costs[i*n + j] = ws.visited(cell) ? ws.dist(cell) : TOUR_INF;
+            }
+            if(parents)
+            {
+                (*parents)[i].assign(ws.parents(), ws.parents() + size_t(m.rows())*cols);
+            }
+        }
+#ifdef MAZE_STATS
+        if(local_stats)
+        {
+            lock_guard<mutex> guard(stats_lock);
+            if(helper)
+            {
+                local.bytes_allocated = thread_bytes_allocated() - start_bytes;
+            }
+            stats->add(local);
+        }
+#endif
+    };
+
+    if(threads <= 0)
+    {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    int nthreads = min(n, threads);
+    vector<thread> workers;
+    for(int t = 1; t < nthreads; t++)
+    {
+        workers.emplace_back(worker, true);
+    }
+    worker(false);
+    for(auto& t : workers)
+    {
+        t.join();
+    }
+    return costs;
+}
+
+/**
+ * Fill in one layer of the Held-Karp table.
+ * dp[S*K + j] is the cheapest way to start at waypoint 0,
+ * visit every waypoint in S, and finish at waypoint j+1 (which is in S).
+ * Every subset in the layer has the same number of waypoints,
+ * so they only depend on the previous layer and can be split across threads.
+ *
+ * @param dp the table
+ * @param ddT ddT[b*K + a] is the cost from waypoint a+1 to waypoint b+1,
+ *            stored transposed so the costs into one waypoint are contiguous
+ * @param first the cost from waypoint 0 to every other waypoint
+ * @param k the number of waypoints not counting the start
+ * @param K the row length of dp and ddT: k rounded up to a whole LANES,
+ *          with the padding at TOUR_INF
+ * @param size the number of waypoints in every subset of this layer
+ * @param lo the first subset to look at
+ * @param hi one past the last subset to look at
+ */
+static void held_karp_layer(vector<int>& dp, const vector<int>& ddT, const vector<int>& first,
+                            int k, int K, int size, unsigned lo, unsigned hi)
+{
+    for(unsigned S = lo; S < hi; S++)
+    {
+        if(__builtin_popcount(S) != size)
+        {
+            continue;
+        }
+        for(int j = 0; j < k; j++)
+        {
+            if(!(S & (1u << j)))
+            {
+                continue;
+            }
+
+            unsigned prev = S ^ (1u << j);
+            if(prev == 0)
+            {
+                dp[S*K + j] = first[j];
+                continue;
+            }
+
+            // entries for waypoints that aren't in prev are TOUR_INF,
+            // so we can take the min over every K without branching.
+            // Both rows are contiguous and padded to whole LANES,
+            // so the inner loop turns into vector instructions, even at -O2.
+            const int* row = &dp[prev*K];
+            const int* into = &ddT[j*K];
+            int best[LANES];
+            fill(best, best+LANES, TOUR_INF);
+            for(int i = 0; i < K; i += LANES)
+            {
+                for(int l = 0; l < LANES; l++)
+                {
+                    best[l] = min(best[l], row[i+l] + into[i+l]);
+                }
+            }
+            dp[S*K + j] = min(*min_element(best, best+LANES), TOUR_INF);
+        }
+    }
+}
+
+/**
+ * Find the cheapest closed tour through all of the waypoints.
+ *
+ * First we find the cost between every pair of waypoints,
+ * then we use the Held-Karp dynamic program to find the best order to visit them,
+ * and finally we stitch the shortest paths between waypoints together.
+ */
+path solve_waypoint_tour(const Maze& m, const vector<point>& waypoints, int& cost,
+                         RunStats* stats, const Components* components, int threads)
+{
+    cost = -1;
+    int n = waypoints.size();
+    if(threads <= 0)
+    {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    if(n == 0 || n > MAX_WAYPOINTS)
+    {
+        return path();
+    }
+    for(auto [r,c] : waypoints)
+    {
+        if(r < 0 || r >= m.rows() || c < 0 || c >= m.columns())
+        {
+            return path();
+        }
+    }
+
+    // every waypoint has to be in the start's component
+    STAT(stats, begin_phase("components"));
+    unique_ptr<Components> labeled;
+    if(!components)
+    {
+        labeled.reset(new Components(m, threads));
+        components = labeled.get();
+    }
+    bool reachable = all_of(waypoints.begin(), waypoints.end(), [&](const point& p)
+    {
+        return components->connected(p, waypoints[0]);
+    });
+    STAT(stats, end_phase());
+    if(!reachable)
+    {
+        return path();
+    }
+
+    STAT(stats, begin_phase("cost matrix"));
+    vector<vector<unsigned char>> parents;
+    vector<int> costs = waypoint_costs(m, waypoints, &parents, stats, threads);
+    STAT(stats, end_phase());
+
+    // the order we visit the waypoints in, not counting the start at either end
+    vector<int> order;
+    int k = n-1;
+
+    if(k == 0)
+    {
+        cost = 0;
+    }
+    else
+    {
+        // costs between the waypoints other than the start
+        // (transposed and padded, see held_karp_layer)
+        int K = (k + LANES-1) / LANES * LANES;
+        vector<int> ddT(k*K, TOUR_INF);
+        vector<int> first(k);
+        for(int a = 0; a < k; a++)
+        {
+            first[a] = costs[a+1];
+            for(int b = 0; b < k; b++)
+            {
+                ddT[b*K + a] = costs[(a+1)*n + b+1];
+            }
+        }
+
+        STAT(stats, begin_phase("held-karp"));
+        unsigned full = (1u << k) - 1;
+        vector<int> dp((full+1)*K, TOUR_INF);
+
+        // small tables aren't worth starting threads for
+        int nthreads = k < 12 ? 1 : threads;
+        for(int size = 1; size <= k; size++)
+        {
+            unsigned chunk = (full+1 + nthreads-1) / nthreads;
+            vector<thread> workers;
+            for(int t = 1; t < nthreads; t++)
+            {
+                unsigned lo = min(full+1, t*chunk);
+                unsigned hi = min(full+1, lo+chunk);
+                workers.emplace_back(held_karp_layer, ref(dp), cref(ddT), cref(first), k, K, size, lo, hi);
+            }
+            held_karp_layer(dp, ddT, first, k, K, size, 0, min(full+1, chunk));
+            for(auto& t : workers)
+            {
+                t.join();
+            }
+        }
+
+        // close the tour by going back to the start
+        int best = TOUR_INF;
+        int last = -1;
+        for(int j = 0; j < k; j++)
+        {
+            int total = dp[full*K + j] + costs[(j+1)*n];
+            if(total < best)
+            {
+                best = total;
+                last = j;
+            }
+        }
+        STAT(stats, end_phase());
+        if(last < 0)
+        {
+            return path();
+        }
+        cost = best;
+
+        // walk the table backwards to recover the order
+        unsigned S = full;
+        int j = last;
+        while(j >= 0)
+        {
+            order.push_back(j+1);
+            unsigned prev = S ^ (1u << j);
+            int from = -1;
+            for(int i = 0; i < k && prev; i++)
+            {
+                if((prev & (1u << i)) && dp[prev*K + i] + ddT[j*K + i] == dp[S*K + j])
+                {
+                    from = i;
+                    break;
+                }
+            }
+            S = prev;
+            j = from;
+        }
+        reverse(order.begin(), order.end());
+    }
+    order.push_back(0);
+
+    // stitch the legs together.
+    // parents[a] leads back to waypoint a, so we walk each leg from its end.
+    STAT(stats, begin_phase("stitch"));
+    int cols = m.columns();
+    path tour;
+    tour.push_back(waypoints[0]);
+    int from = 0;
+    for(int to : order)
+    {
+        path leg;
+        point p = waypoints[to];
+        while(p != waypoints[from])
+        {
+            leg.push_front(p);
+            p = p + moveIn(parents[from][p.first*cols + p.second]);
+        }
+        tour.splice(tour.end(), leg);
+        from = to;
+    }
+    STAT(stats, end_phase());
+    return tour;
+}
@@ -0,0 +1,55 @@
+#ifndef TOUR_H
+#define TOUR_H
+
+#include "maze.h"
+#include "components.h"
+#include "path.h"
+#include <vector>
+
+// The Held-Karp table has 2^(n-1) * (n-1) entries,
+// so 20 waypoints is about 40MB of ints.
+const int MAX_WAYPOINTS = 20;
+
+// cost used for pairs of waypoints that can't reach each other
+const int TOUR_INF = 1 << 29;
+
+/**
+ * Find the cheapest closed tour through a set of waypoints.
+ * The tour starts at waypoints[0], visits every other waypoint
+ * in whatever order is cheapest, and comes back to waypoints[0].
+ *
+ * The cost of a move is the height difference between the two rooms,
+ * the same as Maze::cost.
+ *
+ * Waypoints that are outside the maze, or can't be reached from the start,
+ * are caught from the component labels before any searching.
+ *
+ * @param m the maze
+ * @param waypoints the rooms to visit, waypoints[0] is the start
+ * @param cost set to the total cost of the tour, or -1 if there is no tour
+ * @param stats counters for the tour, may be null
+ * @param components the maze's components, if null they're labeled here
+ * @param threads the most threads to use for any step, 0 for one per core
+ * @return the tour as a list of adjacent rooms, or an empty path
+ */
+path solve_waypoint_tour(const Maze& m, const vector<point>& waypoints, int& cost,
+                         RunStats* stats = nullptr, const Components* components = nullptr,
+                         int threads = 0);
+
+/**
+ * Compute the cost of the cheapest path between every pair of waypoints.
+ * Runs one shortest path search per waypoint, spread over the available cores.
+ *
+ * @param m the maze
+ * @param waypoints the rooms to connect
+ * @param parents if not null, parents[i] is filled with the direction
+ *                to step back towards waypoints[i] from every room
+ * @param stats gets the combined counters of all of the searches, may be null
+ * @param threads number of threads, 0 for one per core
+ * @return an n*n row major matrix, unreachable pairs are TOUR_INF
+ */
+vector<int> waypoint_costs(const Maze& m, const vector<point>& waypoints,
+                           vector<vector<unsigned char>>* parents,
+                           RunStats* stats = nullptr, int threads = 0);
+
+#endif // TOUR_H
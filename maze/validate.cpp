@@ -0,0 +1,57 @@
+#include "validate.h"
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// don't split a path into chunks shorter than this
+const size_t MIN_CHUNK = 1 << 16;
+
+PathCheck check_path(const Maze& m, const path& p, const vector<point>& waypoints)
+{
+    PathValidator v(m, waypoints);
+    v.steps(p.begin(), p.end());
+    return v.result();
+}
+
+PathCheck check_path(const Maze& m, const point* begin, const point* end,
+                     const vector<point>& waypoints, int threads)
+{
+    size_t n = end - begin;
+    if(threads <= 0)
+    {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    size_t chunks = max<size_t>(1, min<size_t>(threads, n / MIN_CHUNK));
+
+    vector<PathCheck> checks(chunks);
+    auto check_chunk = [&](size_t i)
+    {
+        const point* lo = begin + n*i / chunks;
+        const point* hi = begin + n*(i+1) / chunks;
+        PathValidator v(m, waypoints);
+        if(lo != begin)
+        {
+            v.resume(lo[-1]);
+        }
+        v.steps(lo, hi);
+        checks[i] = v.result();
+    };
+
+    vector<thread> workers;
+    for(size_t i = 1; i < chunks; i++)
+    {
+        workers.emplace_back(check_chunk, i);
+    }
+    check_chunk(0);
+    for(auto& t : workers)
+    {
+        t.join();
+    }
+
+    for(size_t i = 1; i < chunks; i++)
+    {
+        checks[0].append(checks[i]);
+    }
+    return checks[0];
+}
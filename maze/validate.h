@@ -0,0 +1,260 @@
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include "maze.h"
+#include "path.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * What one pass over a path found.
+ */
+struct PathCheck
+{
+    // every room is in the maze, and every step goes to a neighbor through an open wall
+    bool valid = true;
+    size_t rooms = 0;
+    // total height difference, for every step between two rooms in the maze
+    long long cost = 0;
+    point front = make_pair(-1, -1);
+    point back = make_pair(-1, -1);
+    // seen[i] if waypoints[i] is on the path
+    vector<bool> seen;
+
+    /**
+     * @return if every waypoint is on the path
+     */
+    bool saw_all() const { return find(seen.begin(), seen.end(), false) == seen.end(); }
+
+    /**
+     * add the check of the part of the path that comes right after this one
+     */
+    void append(const PathCheck& next)
+    {
+        valid = valid && next.valid;
+        if(rooms == 0)
+        {
+            front = next.front;
+        }
+        if(next.rooms > 0)
+        {
+            back = next.back;
+        }
+        rooms += next.rooms;
+        cost += next.cost;
+        for(size_t i = 0; i < seen.size(); i++)
+        {
+            seen[i] = seen[i] || next.seen[i];
+        }
+    }
+};
+
+/**
+ * Checks a path one room at a time, so the path never has to be stored.
+ * Adjacency, walls, waypoints and cost are all worked out in the same pass.
+ *
+ * PathValidator checks paths in the row major Maze.
+ */
+template<class Layout>
+class BasicPathValidator
+{
+private:
+    const BasicMaze<Layout>& _m;
+
+    // the waypoints as (room number, index), sorted.
+    // A room only has to be looked up if its bit in the filter is set.
+    vector<pair<long long, int>> _waypoints;
+    uint64_t _filter[16];
+
+    PathCheck _check;
+
+    // everything a step touches, apart from the waypoints.
+    // steps() works on a local copy so it can stay in registers.
+    struct Cursor
+    {
+        point last = make_pair(-1, -1);
+        bool has_last = false;
+        bool last_inside = false;
+        int last_height = 0;
+        size_t rooms = 0;
+        long long cost = 0;
+        bool valid = true;
+    };
+    Cursor _cur;
+
+    static int filter_bit(long long room) { return room & 1023; }
+
+    bool inside(const point& p) const
+    {
+        return unsigned(p.first) < unsigned(_m.rows()) && unsigned(p.second) < unsigned(_m.columns());
+    }
+
+    void step(Cursor& cur, const point& p)
+    {
+        cur.rooms++;
+
+        bool in = inside(p);
+        int height = in ? _m.height(p.first, p.second) : 0;
+        if(!in)
+        {
+            cur.valid = false;
+        }
+        else if(cur.has_last)
+        {
+            int dir = direction(cur.last, p);
+            if(!cur.last_inside || dir == FAIL || !_m.can_go(dir, cur.last.first, cur.last.second))
+            {
+                cur.valid = false;
+            }
+            if(cur.last_inside)
+            {
+                cur.cost += abs(height - cur.last_height);
+            }
+        }
+
+        if(in)
+        {
+            long long room = (long long)p.first * _m.columns() + p.second;
+            if(_filter[filter_bit(room) / 64] >> (filter_bit(room) % 64) & 1)
+            {
+                auto it = lower_bound(_waypoints.begin(), _waypoints.end(), make_pair(room, -1));
+                for(; it != _waypoints.end() && it->first == room; it++)
+                {
+                    _check.seen[it->second] = true;
+                }
+            }
+        }
+
+        cur.last = p;
+        cur.has_last = true;
+        cur.last_inside = in;
+        cur.last_height = height;
+    }
+
+public:
+    BasicPathValidator(const BasicMaze<Layout>& m, const vector<point>& waypoints = vector<point>())
+        : _m(m)
+    {
+        fill(_filter, _filter+16, 0);
+        for(size_t i = 0; i < waypoints.size(); i++)
+        {
+            long long room = (long long)waypoints[i].first * m.columns() + waypoints[i].second;
+            if(inside(waypoints[i]))
+            {
+                _waypoints.push_back(make_pair(room, int(i)));
+                _filter[filter_bit(room) / 64] |= uint64_t(1) << (filter_bit(room) % 64);
+            }
+        }
+        sort(_waypoints.begin(), _waypoints.end());
+        _check.seen.assign(waypoints.size(), false);
+    }
+
+    /**
+     * carry on from p, the last room of a part of the path checked somewhere else.
+     * p isn't counted, but the step from it to the next room is.
+     */
+    void resume(const point& p)
+    {
+        _cur.last = p;
+        _cur.has_last = true;
+        _cur.last_inside = inside(p);
+        _cur.last_height = _cur.last_inside ? _m.height(p.first, p.second) : 0;
+    }
+
+    /**
+     * the next room on the path
+     */
+    void step(const point& p)
+    {
+        if(_cur.rooms == 0)
+        {
+            _check.front = p;
+        }
+        step(_cur, p);
+    }
+
+    template<class It>
+    void steps(It begin, It end)
+    {
+        if(begin == end)
+        {
+            return;
+        }
+        if(_cur.rooms == 0)
+        {
+            _check.front = *begin;
+        }
+        Cursor cur = _cur;
+        for(; begin != end; ++begin)
+        {
+            step(cur, *begin);
+        }
+        _cur = cur;
+    }
+
+    const PathCheck& result()
+    {
+        _check.valid = _cur.valid;
+        _check.rooms = _cur.rooms;
+        _check.cost = _cur.cost;
+        if(_cur.rooms > 0)
+        {
+            _check.back = _cur.last;
+        }
+        return _check;
+    }
+
+};
+
+using PathValidator = BasicPathValidator<RowMajorLayout>;
+
+/**
+ * @return the waypoints of the corners tour: the center, then the four corners
+ */
+inline vector<point> corner_waypoints(int rows, int cols)
+{
+    return {make_pair(rows/2, cols/2),
+            make_pair(0, 0),
+            make_pair(0, cols-1),
+            make_pair(rows-1, 0),
+            make_pair(rows-1, cols-1)};
+}
+
+/**
+ * @return if the checked path goes from (0,0) to (rows-1,cols-1)
+ */
+inline bool is_solution(const PathCheck& c, int rows, int cols)
+{
+    return c.valid && c.rooms > 0 &&
+           c.front == make_pair(0, 0) && c.back == make_pair(rows-1, cols-1);
+}
+
+/**
+ * @return if the checked path starts and ends at start and saw every waypoint
+ */
+inline bool is_tour(const PathCheck& c, const point& start)
+{
+    return c.valid && c.rooms > 0 && c.front == start && c.back == start && c.saw_all();
+}
+
+/**
+ * Check a whole path in one pass.
+ */
+PathCheck check_path(const Maze& m, const path& p, const vector<point>& waypoints = vector<point>());
+
+/**
+ * Check a path that's stored in an array.
+ * Long paths are split into chunks that are checked on separate threads,
+ * each chunk starting from the last room of the one before.
+ *
+ * @param threads number of threads, 0 for one per core
+ */
+PathCheck check_path(const Maze& m, const point* begin, const point* end,
+                     const vector<point>& waypoints = vector<point>(), int threads = 0);
+
+#endif // VALIDATE_H
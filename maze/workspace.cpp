@@ -0,0 +1,79 @@
+#include "workspace.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////
+//
+// Arena
+//
+////////////////////////////////////////////////////////////////////////
+
+Arena::Arena(size_t block_size)
+    : _block_size(block_size), _cur(nullptr), _left(0), _bytes(0)
+{
+}
+
+void Arena::grow(size_t bytes)
+{
+    size_t size = max(_block_size, bytes);
+    _blocks.emplace_back(new char[size]);
+    _cur = _blocks.back().get();
+    _left = size;
+    _bytes += size;
+}
+
+void Arena::reset(size_t bytes)
+{
+    _blocks.clear();
+    _cur = nullptr;
+    _left = 0;
+    _bytes = 0;
+    if(bytes)
+    {
+        grow(bytes);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// SolverWorkspace
+//
+////////////////////////////////////////////////////////////////////////
+
+SolverWorkspace::SolverWorkspace()
+    : _capacity(0), _epoch(0), _stamp(nullptr), _dist(nullptr), _parent(nullptr),
+      _queue(nullptr), _link(nullptr), _path(nullptr), _path_len(0)
+{
+}
+
+void SolverWorkspace::begin(size_t cells)
+{
+    if(cells > _capacity)
+    {
+        // everything goes in one block, with a little room for alignment
+        size_t q = queue_size(cells);
+        size_t bytes = cells * (2*sizeof(uint32_t) + 1 + sizeof(point)) + 2*q*sizeof(int) + 64;
+        _arena.reset(bytes);
+
+        _stamp  = _arena.alloc<uint32_t>(cells);
+        _dist   = _arena.alloc<uint32_t>(cells);
+        _queue  = _arena.alloc<int>(q);
+        _link   = _arena.alloc<int>(q);
+        _path   = _arena.alloc<point>(cells);
+        _parent = _arena.alloc<unsigned char>(cells);
+
+        memset(_stamp, 0, cells * sizeof(uint32_t));
+        _capacity = cells;
+        _epoch = 0;
+    }
+
+    // the stamps only need clearing when the epoch wraps around
+    if(++_epoch == 0)
+    {
+        memset(_stamp, 0, _capacity * sizeof(uint32_t));
+        _epoch = 1;
+    }
+    _path_len = 0;
+}
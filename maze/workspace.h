@@ -0,0 +1,155 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include "path.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/**
+ * A bump allocator.
+ * Memory comes out of big blocks and is only given back by reset()
+ * or when the arena is destroyed, there's no per allocation free.
+ */
+class Arena
+{
+private:
+    vector<unique_ptr<char[]>> _blocks;
+    size_t _block_size;
+    char* _cur;
+    size_t _left;
+    size_t _bytes;
+
+public:
+    explicit Arena(size_t block_size = 1 << 20);
+
+    /**
+     * @return space for n T's, aligned for T and not initialized
+     */
+    template<class T>
+    T* alloc(size_t n)
+    {
+        size_t pad = (alignof(T) - uintptr_t(_cur) % alignof(T)) % alignof(T);
+        if(pad + n*sizeof(T) > _left)
+        {
+            grow(n*sizeof(T) + alignof(T));
+            pad = (alignof(T) - uintptr_t(_cur) % alignof(T)) % alignof(T);
+        }
+        T* p = reinterpret_cast<T*>(_cur + pad);
+        _cur += pad + n*sizeof(T);
+        _left -= pad + n*sizeof(T);
+        return p;
+    }
+
+    /**
+     * free everything, and make sure the next block holds at least bytes
+     */
+    void reset(size_t bytes = 0);
+
+    /**
+     * @return the number of bytes the arena holds
+     */
+    size_t bytes() const { return _bytes; }
+
+private:
+    void grow(size_t bytes);
+};
+
+/**
+ * Everything a solver needs for one search, allocated once and reused.
+ *
+ * Instead of clearing the visited array before each search,
+ * every search gets a new epoch, and a room has been visited
+ * in this search if its stamp is the current epoch.
+ * dist and parent are only meaningful for visited rooms.
+ * Rooms are whatever numbers the search uses, usually the maze layout's index,
+ * so the arrays line up with the maze in memory.
+ *
+ * Once the workspace has been sized for a maze,
+ * repeated searches on mazes that size don't touch the heap.
+ */
+class SolverWorkspace
+{
+private:
+    Arena _arena;
+    size_t _capacity;
+    uint32_t _epoch;
+
+    uint32_t* _stamp;
+    uint32_t* _dist;
+    unsigned char* _parent;
+    int* _queue;    // FIFO, stack or bucket entries
+    int* _link;     // next entry in the same bucket
+    point* _path;
+    size_t _path_len;
+
+public:
+    // every room can be pushed at most once per neighbor, plus the start
+    static size_t queue_size(size_t cells) { return 4*cells + 1; }
+
+    SolverWorkspace();
+
+    /**
+     * get ready for a search over cells rooms.
+     * Grows the arrays if they're too small, otherwise just starts a new epoch.
+     */
+    void begin(size_t cells);
+
+    bool visited(size_t i) const { return _stamp[i] == _epoch; }
+    void visit(size_t i)         { _stamp[i] = _epoch; }
+
+    uint32_t& dist(size_t i)         { return _dist[i]; }
+    unsigned char& parent(size_t i)  { return _parent[i]; }
+    const unsigned char* parents() const { return _parent; }
+    int* queue()                     { return _queue; }
+    int* link()                      { return _link; }
+
+    /**
+     * set the path to the rooms from src to goal,
+     * following the parents back from goal.
+     * Rooms are numbered by their index in layout (see layout.h).
+     */
+    template<class Layout>
+    void trace_path(int src, int goal, const Layout& layout)
+    {
+        // count the rooms first, so we can fill the path in from the back
+        size_t n = 1;
+        point p = make_pair(layout.row(goal), layout.column(goal));
+        for(int i = goal; i != src; n++)
+        {
+            p = p + moveIn(_parent[i]);
+            i = layout.index(p.first, p.second);
+        }
+
+        _path_len = n;
+        p = make_pair(layout.row(goal), layout.column(goal));
+        _path[--n] = p;
+        for(int i = goal; i != src; )
+        {
+            p = p + moveIn(_parent[i]);
+            i = layout.index(p.first, p.second);
+            _path[--n] = p;
+        }
+    }
+
+    void clear_path() { _path_len = 0; }
+
+    const point* path_begin() const { return _path; }
+    const point* path_end() const   { return _path + _path_len; }
+    size_t path_size() const        { return _path_len; }
+
+    /**
+     * @return a copy of the path as a list, for the old solver interface
+     */
+    path to_list() const { return path(path_begin(), path_end()); }
+
+    /**
+     * @return the number of bytes the workspace holds
+     */
+    size_t bytes() const { return _arena.bytes(); }
+};
+
+#endif // WORKSPACE_H